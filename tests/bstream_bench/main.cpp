@@ -0,0 +1,648 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "yasio/ibstream.hpp"
+#include "yasio/obstream.hpp"
+#include "yasio/schema.hpp"
+#include "yasio/pbwire.hpp"
+#include "yasio/yasio.hpp"
+
+using namespace yasio;
+
+// The bulk array benchmark: encodes & decodes number arrays element by element with
+// write_i/read_i, and by span with write_array/read_array, reports the throughput of each. Then
+// the varint arrays with read_i7 loop and the batch decoding read_i7_array/read_z7_array. At last
+// the messages decoding of throwing ibstream_view and checked_ibstream_view, for both valid and
+// truncated messages, and of segmented_ibstream_view over the messages split into slices. The
+// hand-written encoding against yasio::schema(with the round trip of all number types), and the
+// protobuf wire encoding & decoding of the same message by yasio::pb. At last the length field
+// based frames decoding by std::function with params branches, and by the decoder instantiated
+// for the length field size.
+// usage: bstreambench [count:int(10000)] [rounds:int(1000)]
+static long long clock_us()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <typename _Nty> static void fill(std::vector<_Nty>& values)
+{
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = static_cast<_Nty>(i * 2654435761u);
+}
+
+template <typename _Nty>
+static bool run_benchmark(const char* title, int count, int rounds)
+{
+  std::vector<_Nty> values(count), decoded(count);
+  fill(values);
+  double mbytes = static_cast<double>(count) * sizeof(_Nty) * rounds / (1024 * 1024);
+
+  obstream obs(count * sizeof(_Nty));
+  auto time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    obs.buffer().clear();
+    for (int i = 0; i < count; ++i)
+      obs.write_i(values[i]);
+  }
+  auto scalar_write = clock_us() - time_start;
+  std::vector<char> expected = obs.buffer();
+
+  time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    ibstream_view ibs(obs.data(), static_cast<int>(obs.length()));
+    for (int i = 0; i < count; ++i)
+      decoded[i] = ibs.read_i<_Nty>();
+  }
+  auto scalar_read = clock_us() - time_start;
+
+  time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    obs.buffer().clear();
+    obs.write_array(values.data(), values.size());
+  }
+  auto span_write = clock_us() - time_start;
+  bool ok = obs.buffer() == expected;
+
+  time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    ibstream_view ibs(obs.data(), static_cast<int>(obs.length()));
+    ibs.read_array(decoded.data(), decoded.size());
+  }
+  auto span_read = clock_us() - time_start;
+  ok = ok && ::memcmp(decoded.data(), values.data(), count * sizeof(_Nty)) == 0;
+
+  auto speed = [=](long long elapsed) { return elapsed > 0 ? mbytes * 1000000 / elapsed : 0.0; };
+  printf("[%s] %s, write_i:%.1lfMB/s, write_array:%.1lfMB/s, read_i:%.1lfMB/s, "
+         "read_array:%.1lfMB/s\n",
+         title, ok ? "ok" : "mismatch", speed(scalar_write), speed(span_write), speed(scalar_read),
+         speed(span_read));
+  return ok;
+}
+
+// The state updates are mostly small deltas, 'small_percent' of values are below 128
+static bool run_varint_benchmark(const char* title, int small_percent, int count, int rounds)
+{
+  std::vector<int32_t> values(count), decoded(count);
+  uint32_t seed = 20200314;
+  for (int i = 0; i < count; ++i)
+  {
+    seed      = seed * 1103515245 + 12345;
+    values[i] = static_cast<int32_t>((seed >> 8) % 100 < (uint32_t)small_percent
+                                         ? static_cast<int>(seed >> 16) % 64
+                                         : static_cast<int>(seed));
+  }
+
+  obstream obs(count * 5);
+  obs.write_z7_array(values.data(), values.size());
+  double mvalues = static_cast<double>(count) * rounds / 1000000;
+
+  auto time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    ibstream_view ibs(obs.data(), static_cast<int>(obs.length()));
+    for (int i = 0; i < count; ++i)
+      decoded[i] = yasio::bits::zigzag_decode32(static_cast<uint32_t>(ibs.read_i7()));
+  }
+  auto scalar_read = clock_us() - time_start;
+  bool ok          = decoded == values;
+
+  std::fill(decoded.begin(), decoded.end(), 0);
+  time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    ibstream_view ibs(obs.data(), static_cast<int>(obs.length()));
+    ibs.read_z7_array(decoded.data(), decoded.size());
+  }
+  auto batch_read = clock_us() - time_start;
+  ok              = ok && decoded == values;
+
+  // the 64 bits varints
+  obstream obs64;
+  for (int i = 0; i < count; ++i)
+    obs64.write_zx(static_cast<int64_t>(values[i]) * values[i] * (i % 2 ? -1 : 1));
+  ibstream_view ibs64(obs64.data(), static_cast<int>(obs64.length()));
+  for (int i = 0; i < count; ++i)
+    ok = ok && ibs64.read_zx() == static_cast<int64_t>(values[i]) * values[i] * (i % 2 ? -1 : 1);
+
+  auto speed = [=](long long elapsed) { return elapsed > 0 ? mvalues * 1000000 / elapsed : 0.0; };
+  printf("[%s] %s, bytes per value:%.2lf, read_i7:%.1lfM/s, read_z7_array:%.1lfM/s\n", title,
+         ok ? "ok" : "mismatch", static_cast<double>(obs.length()) / count, speed(scalar_read),
+         speed(batch_read));
+  return ok;
+}
+
+struct state_update
+{
+  uint16_t cmd;
+  uint32_t id;
+  cxx17::string_view name;
+  float x, y, z;
+  int64_t timestamp;
+  uint8_t flags;
+};
+
+static bool decode(ibstream_view& ibs, state_update& msg)
+{
+  try
+  {
+    msg.cmd       = ibs.read_i<uint16_t>();
+    msg.id        = ibs.read_i<uint32_t>();
+    msg.name      = ibs.read_va();
+    msg.x         = ibs.read_i<float>();
+    msg.y         = ibs.read_i<float>();
+    msg.z         = ibs.read_i<float>();
+    msg.timestamp = ibs.read_i<int64_t>();
+    msg.flags     = ibs.read_i<uint8_t>();
+    return true;
+  }
+  catch (const std::exception&)
+  {
+    return false;
+  }
+}
+
+static bool decode(checked_ibstream_view& ibs, state_update& msg)
+{
+  msg.cmd  = ibs.read_i<uint16_t>();
+  msg.id   = ibs.read_i<uint32_t>();
+  msg.name = ibs.read_va();
+  if (ibs.require(3 * sizeof(float) + sizeof(int64_t) + sizeof(uint8_t)))
+  { // the fixed size fields group
+    msg.x         = ibs.read_i_unchecked<float>();
+    msg.y         = ibs.read_i_unchecked<float>();
+    msg.z         = ibs.read_i_unchecked<float>();
+    msg.timestamp = ibs.read_i_unchecked<int64_t>();
+    msg.flags     = ibs.read_i_unchecked<uint8_t>();
+  }
+  return ibs.ok();
+}
+
+static bool decode(segmented_ibstream_view& ibs, state_update& msg, std::string& scratch)
+{
+  msg.cmd       = ibs.read_i<uint16_t>();
+  msg.id        = ibs.read_i<uint32_t>();
+  msg.name      = ibs.read_va(scratch);
+  msg.x         = ibs.read_i<float>();
+  msg.y         = ibs.read_i<float>();
+  msg.z         = ibs.read_i<float>();
+  msg.timestamp = ibs.read_i<int64_t>();
+  msg.flags     = ibs.read_i<uint8_t>();
+  return ibs.ok();
+}
+
+template <typename _Stream>
+static long long run_decode(const std::vector<std::vector<char>>& messages, int rounds,
+                            int& decoded)
+{
+  state_update msg;
+  decoded         = 0;
+  auto time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    for (auto& message : messages)
+    {
+      _Stream ibs(message.data(), static_cast<int>(message.size()));
+      if (decode(ibs, msg))
+        ++decoded;
+    }
+  }
+  return clock_us() - time_start;
+}
+
+static bool run_message_benchmark(int count, int rounds)
+{
+  std::vector<std::vector<char>> messages, truncated;
+  for (int i = 0; i < count; ++i)
+  {
+    obstream obs;
+    obs.write_i<uint16_t>(1001);
+    obs.write_i<uint32_t>(i);
+    obs.write_va("player");
+    obs.write_i<float>(i * 0.5f);
+    obs.write_i<float>(i * 1.5f);
+    obs.write_i<float>(i * 2.5f);
+    obs.write_i<int64_t>(1584144000000LL + i);
+    obs.write_i<uint8_t>(i & 0xff);
+    messages.push_back(obs.buffer());
+    // the malformed input, cut at any field
+    truncated.push_back(std::vector<char>(obs.data(), obs.data() + i % obs.length()));
+  }
+
+  // the messages split into 2 slices at any byte, decoded without concatenation
+  std::string scratch;
+  state_update msg, expected;
+  int segmented_decoded = 0;
+  auto time_start       = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+      auto& message = messages[i];
+      auto split    = i % (message.size() + 1);
+      cxx17::string_view slices[2] = {cxx17::string_view(message.data(), split),
+                                      cxx17::string_view(message.data() + split,
+                                                         message.size() - split)};
+      segmented_ibstream_view ibs(slices, 2);
+      if (decode(ibs, msg, scratch) && ibs.remain() == 0)
+        ++segmented_decoded;
+      if (r == 0)
+      { // and the fields are same as the contiguous decoding
+        checked_ibstream_view contiguous(message.data(), static_cast<int>(message.size()));
+        decode(contiguous, expected);
+        if (msg.id != expected.id || msg.name != expected.name || msg.z != expected.z ||
+            msg.timestamp != expected.timestamp || msg.flags != expected.flags)
+          --segmented_decoded;
+      }
+    }
+  }
+  auto segmented = clock_us() - time_start;
+
+  int decoded, checked_decoded, rejected, checked_rejected;
+  auto throwing  = run_decode<ibstream_view>(messages, rounds, decoded);
+  auto checked   = run_decode<checked_ibstream_view>(messages, rounds, checked_decoded);
+  auto throwing2 = run_decode<ibstream_view>(truncated, rounds, rejected);
+  auto checked2  = run_decode<checked_ibstream_view>(truncated, rounds, checked_rejected);
+
+  double mmsgs = static_cast<double>(count) * rounds / 1000000;
+  auto speed   = [=](long long elapsed) { return elapsed > 0 ? mmsgs * 1000000 / elapsed : 0.0; };
+  bool ok      = decoded == count * rounds && checked_decoded == count * rounds &&
+            rejected == 0 && checked_rejected == 0 && segmented_decoded == count * rounds;
+  printf("[messages] %s, ibstream_view:%.2lfM/s, checked_ibstream_view:%.2lfM/s, "
+         "rejecting truncated ibstream_view:%.2lfM/s, checked_ibstream_view:%.2lfM/s, "
+         "segmented_ibstream_view of 2 slices:%.2lfM/s\n",
+         ok ? "ok" : "mismatch", speed(throwing), speed(checked), speed(throwing2),
+         speed(checked2), speed(segmented));
+  return ok;
+}
+
+struct vec3
+{
+  float x, y, z;
+  YASIO_SCHEMA(x, y, z)
+};
+struct player_state
+{
+  uint32_t id;
+  vec3 pos;
+  vec3 velocity;
+  std::string name;
+  std::vector<int32_t> buffs;
+  YASIO_SCHEMA(id, pos, velocity, name, buffs)
+};
+
+// The number types which write_i/read_i don't specialize must round trip too
+enum class wide_enum : long long
+{
+  big = 0x0102030405060708LL,
+};
+struct wide_numbers
+{
+  char c;
+  long long ll;
+  unsigned long long ull;
+  wchar_t wc;
+  char16_t c16;
+  int32_t i;
+  wide_enum e;
+  std::vector<long long> lls;
+  YASIO_SCHEMA(c, ll, ull, wc, c16, i, e, lls)
+};
+
+static bool run_schema_round_trip()
+{
+  wide_numbers value{'y', 0x1122334455667788LL, 0xF1E2D3C4B5A69788ULL, L'w', u'z', -7,
+                     wide_enum::big, {-1, 0x7FFFFFFF00000001LL}};
+  obstream obs;
+  yasio::schema::encode(obs, value);
+  yasio::schema::encode(obs, value.ll); // the variable size path of scalar
+
+  wide_numbers decoded{};
+  long long ll = 0;
+  checked_ibstream_view ibs(obs.data(), static_cast<int>(obs.length()));
+  bool ok = obs.length() == yasio::schema::encoded_size(value) + sizeof(long long) &&
+            obs.data()[1] == 0x11 && yasio::schema::decode(ibs, decoded) &&
+            yasio::schema::decode(ibs, ll) && decoded.c == value.c && decoded.ll == value.ll &&
+            decoded.ull == value.ull && decoded.wc == value.wc && decoded.c16 == value.c16 &&
+            decoded.i == value.i && decoded.e == value.e && decoded.lls == value.lls &&
+            ll == value.ll;
+
+  // the truncated one must fail
+  checked_ibstream_view truncated(obs.data(), 9);
+  return ok && !yasio::schema::decode(truncated, decoded);
+}
+
+static bool run_schema_benchmark(int rounds)
+{
+  player_state state{1001, {1, 2, 3}, {0.5f, 0, -0.5f}, "player", {1, 2, 3, 4, 5, 6, 7, 8}};
+  obstream obs;
+
+  auto time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    obs.buffer().clear();
+    obs.write_i(state.id);
+    obs.write_i(state.pos.x);
+    obs.write_i(state.pos.y);
+    obs.write_i(state.pos.z);
+    obs.write_i(state.velocity.x);
+    obs.write_i(state.velocity.y);
+    obs.write_i(state.velocity.z);
+    obs.write_va(state.name);
+    obs.write_i7(static_cast<int>(state.buffs.size()));
+    for (auto buff : state.buffs)
+      obs.write_i(buff);
+  }
+  auto manual = clock_us() - time_start;
+  std::vector<char> expected = obs.buffer();
+
+  time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    obs.buffer().clear();
+    yasio::schema::encode(obs, state);
+  }
+  auto generated = clock_us() - time_start;
+
+  player_state decoded{};
+  checked_ibstream_view ibs(obs.data(), static_cast<int>(obs.length()));
+  bool ok = obs.buffer() == expected && yasio::schema::decode(ibs, decoded) &&
+            decoded.pos.z == state.pos.z && decoded.name == state.name &&
+            decoded.buffs == state.buffs && run_schema_round_trip();
+
+  double mmsgs = static_cast<double>(rounds) / 1000000;
+  auto speed   = [=](long long elapsed) { return elapsed > 0 ? mmsgs * 1000000 / elapsed : 0.0; };
+  printf("[schema] %s, write_i:%.2lfM/s, schema::encode:%.2lfM/s\n", ok ? "ok" : "mismatch",
+         speed(manual), speed(generated));
+  return ok;
+}
+
+// message player_state { uint32 id = 1; vec3 pos = 2; vec3 velocity = 3; string name = 4;
+//                        repeated int32 buffs = 5 [packed]; }, vec3 { float x = 1; ... }
+static void pb_encode(yasio::pb::writer& pbw, uint32_t field, const vec3& value)
+{
+  pbw.begin_message(field);
+  pbw.write_float(1, value.x);
+  pbw.write_float(2, value.y);
+  pbw.write_float(3, value.z);
+  pbw.end_message();
+}
+static void pb_encode(yasio::pb::writer& pbw, const player_state& state)
+{
+  pbw.write_uint32(1, state.id);
+  pb_encode(pbw, 2, state.pos);
+  pb_encode(pbw, 3, state.velocity);
+  pbw.write_string(4, state.name);
+  pbw.write_packed_uint32(5, reinterpret_cast<const uint32_t*>(state.buffs.data()),
+                          state.buffs.size());
+}
+static bool pb_decode(yasio::pb::reader&& pbr, vec3& value)
+{
+  while (pbr.next())
+  {
+    switch (pbr.field())
+    {
+      case 1:
+        value.x = pbr.read_float();
+        break;
+      case 2:
+        value.y = pbr.read_float();
+        break;
+      case 3:
+        value.z = pbr.read_float();
+        break;
+      default:
+        pbr.skip();
+    }
+  }
+  return pbr.ok();
+}
+static bool pb_decode(yasio::pb::reader& pbr, player_state& state)
+{
+  bool ok = true;
+  state.buffs.clear();
+  while (ok && pbr.next())
+  {
+    switch (pbr.field())
+    {
+      case 1:
+        state.id = pbr.read_uint32();
+        break;
+      case 2:
+        ok = pb_decode(yasio::pb::reader(pbr.read_string()), state.pos);
+        break;
+      case 3:
+        ok = pb_decode(yasio::pb::reader(pbr.read_string()), state.velocity);
+        break;
+      case 4: {
+        auto name = pbr.read_string();
+        state.name.assign(name.data(), name.size());
+        break;
+      }
+      case 5: {
+        yasio::pb::reader packed(pbr.read_string());
+        while (packed.remain() > 0)
+          state.buffs.push_back(packed.read_int32());
+        ok = packed.ok();
+        break;
+      }
+      default:
+        pbr.skip();
+    }
+  }
+  return ok && pbr.ok();
+}
+
+static bool run_pbwire_benchmark(int rounds)
+{
+  player_state state{1001, {1, 2, 3}, {0.5f, 0, -0.5f}, "player", {1, 2, 3, 4, 5, 6, 7, 8}};
+  obstream obs;
+  yasio::pb::writer pbw(obs);
+
+  auto time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+  {
+    obs.buffer().clear();
+    pb_encode(pbw, state);
+  }
+  auto encoding = clock_us() - time_start;
+
+  player_state decoded{};
+  bool ok    = true;
+  time_start = clock_us();
+  for (int r = 0; r < rounds && ok; ++r)
+  {
+    yasio::pb::reader pbr(obs.data(), static_cast<int>(obs.length()));
+    ok = pb_decode(pbr, decoded);
+  }
+  auto decoding = clock_us() - time_start;
+  ok = ok && decoded.id == state.id && decoded.velocity.z == state.velocity.z &&
+       decoded.name == state.name && decoded.buffs == state.buffs;
+
+  // the known encoding of protobuf: 150 of field 1 nested in field 3
+  obstream known;
+  yasio::pb::writer known_writer(known);
+  known_writer.begin_message(3);
+  known_writer.write_uint32(1, 150);
+  known_writer.end_message();
+  ok = ok && known.buffer() == std::vector<char>{0x1a, 0x03, 0x08, (char)0x96, 0x01};
+
+  // the truncated messages never throw, and the one truncated inside a field must fail
+  for (size_t size = 0; size < obs.length(); ++size)
+  {
+    yasio::pb::reader pbr(obs.data(), static_cast<int>(size));
+    pb_decode(pbr, decoded);
+  }
+  yasio::pb::reader truncated(obs.data(), static_cast<int>(obs.length() - 1));
+  ok = ok && !pb_decode(truncated, decoded);
+
+  double mmsgs = static_cast<double>(rounds) / 1000000;
+  auto speed   = [=](long long elapsed) { return elapsed > 0 ? mmsgs * 1000000 / elapsed : 0.0; };
+  printf("[pbwire] %s, bytes:%d, encode:%.2lfM/s, decode:%.2lfM/s\n", ok ? "ok" : "mismatch",
+         static_cast<int>(obs.length()), speed(encoding), speed(decoding));
+  return ok;
+}
+
+// The decoder branches on the params of each frame, called by std::function
+static int decode_len_branchy(void* ptr, int len, int offset, int size, int adjustment,
+                              int max_frame_length)
+{
+  if (offset < 0)
+    return len;
+  if (len < offset + size)
+    return 0;
+  auto field     = static_cast<unsigned char*>(ptr) + offset;
+  uint32_t value = 0;
+  switch (size)
+  {
+    case 4:
+      ::memcpy(&value, field, 4);
+      value = ntohl(value);
+      break;
+    case 3:
+      ::memcpy(&value, field, 3);
+      value = ntohl(value) >> 8;
+      break;
+    case 2:
+      ::memcpy(&value, field, 2);
+      value = ntohs(static_cast<uint16_t>(value));
+      break;
+    case 1:
+      value = *field;
+      break;
+    default:
+      return -1;
+  }
+  int length = static_cast<int>(value) + adjustment;
+  return length <= max_frame_length ? length : -1;
+}
+
+template <typename _Fty> static int walk_frames(const std::vector<char>& frames, const _Fty& decode)
+{
+  int count = 0;
+  for (size_t offset = 0; offset < frames.size(); ++count)
+  {
+    int length = decode(const_cast<char*>(frames.data()) + offset,
+                        static_cast<int>(frames.size() - offset));
+    if (length <= 0)
+      return -1;
+    offset += length;
+  }
+  return count;
+}
+
+static bool run_frame_benchmark(int count, int rounds)
+{
+  // [length:u16][payload], the length field is the payload size
+  obstream obs;
+  for (int i = 0; i < count; ++i)
+  {
+    obs.push16();
+    obs.buffer().resize(obs.length() + 8 + i % 32);
+    obs.pop16();
+  }
+  auto& frames = obs.buffer();
+
+  volatile int configured = 2; // the params are known at channel open only
+  int field_size = configured, offset = 0, adjustment = 2, max_frame_length = 65536;
+  inet::decode_len_fn_t branchy = [&](void* ptr, int len) {
+    return decode_len_branchy(ptr, len, offset, field_size, adjustment, max_frame_length);
+  };
+  inet::lfb_decode_len_fn_t selected = field_size == 2 ? inet::lfb_decode_len<2>
+                                                       : inet::lfb_decode_len<4>;
+
+  int decoded = 0, selected_decoded = 0;
+
+  auto time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+    decoded += walk_frames(frames, branchy);
+  auto function = clock_us() - time_start;
+
+  time_start = clock_us();
+  for (int r = 0; r < rounds; ++r)
+    selected_decoded += walk_frames(frames, [&](void* ptr, int len) {
+      return selected(ptr, len, offset, adjustment, max_frame_length);
+    });
+  auto instantiated = clock_us() - time_start;
+
+  double mframes = static_cast<double>(count) * rounds / 1000000;
+  auto speed = [=](long long elapsed) { return elapsed > 0 ? mframes * 1000000 / elapsed : 0.0; };
+  bool ok    = decoded == count * rounds && selected_decoded == count * rounds;
+  printf("[frames] %s, std::function:%.1lfM/s, lfb_decode_len<2>:%.1lfM/s\n",
+         ok ? "ok" : "mismatch", speed(function), speed(instantiated));
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+  int count  = argc > 1 ? atoi(argv[1]) : 10000;
+  int rounds = argc > 2 ? atoi(argv[2]) : 1000;
+
+  bool ok = run_benchmark<int16_t>("int16", count, rounds);
+  ok      = run_benchmark<int32_t>("int32", count, rounds) && ok;
+  ok      = run_benchmark<float>("float", count, rounds) && ok;
+  ok      = run_benchmark<int64_t>("int64", count, rounds) && ok;
+  ok      = run_benchmark<double>("double", count, rounds) && ok;
+  ok      = run_varint_benchmark("varint small", 100, count, rounds) && ok;
+  ok      = run_varint_benchmark("varint mixed", 80, count, rounds) && ok;
+  ok      = run_varint_benchmark("varint large", 0, count, rounds) && ok;
+  ok      = run_message_benchmark(count, rounds / 10 + 1) && ok;
+  ok      = run_schema_benchmark(count * rounds / 10 + 1) && ok;
+  ok      = run_pbwire_benchmark(count * rounds / 10 + 1) && ok;
+  ok      = run_frame_benchmark(count, rounds) && ok;
+
+  // the span out of range must throw without reading
+  obstream obs;
+  obs.write_i<int32_t>(1);
+  ibstream_view ibs(obs.data(), static_cast<int>(obs.length()));
+  int32_t pair[2];
+  try
+  {
+    ibs.read_array(pair, 2);
+    ok = false;
+  }
+  catch (const std::out_of_range&)
+  {}
+
+  // the varint more than 5 bytes must throw
+  std::vector<char> malformed(32, static_cast<char>(0xff));
+  uint32_t value;
+  try
+  {
+    ibstream_view(malformed.data(), static_cast<int>(malformed.size())).read_i7_array(&value, 1);
+    ok = false;
+  }
+  catch (const std::logic_error&)
+  {}
+
+  return ok ? 0 : 1;
+}
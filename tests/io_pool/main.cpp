@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "yasio/yasio.hpp"
+
+using namespace yasio;
+using namespace yasio::inet;
+
+// The io_pool test: an echo server at channel 0, and the pool over the client channels [1, 5).
+// Warms up the pool, checks out a transport to echo a message and checks it in, then checks out
+// another one and lets the server drop it, the stale handle must be released safely and the
+// pool replenishes the idle transports.
+// usage: iopooltest [port:int(30631)]
+static const int s_pool_first = 1;
+static const int s_pool_size  = 4;
+static const int s_warmup     = 2;
+
+template <typename _Pred> static bool wait_until(_Pred pred, int timeout_ms = 5000)
+{
+  for (int elapsed = 0; elapsed < timeout_ms; elapsed += 10)
+  {
+    if (pred())
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return pred();
+}
+
+int main(int argc, char** argv)
+{
+  u_short port = static_cast<u_short>(argc > 1 ? atoi(argv[1]) : 30631);
+
+  io_hostent hosts[s_pool_first + s_pool_size];
+  for (auto& host : hosts)
+  {
+    host.set_ip("127.0.0.1");
+    host.set_port(port);
+  }
+  io_service service(hosts, YASIO_ARRAYSIZE(hosts));
+  service.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  service.set_option(YOPT_C_MOD_FLAGS, 0, YCF_REUSEADDR, 0);
+  for (int index = 0; index < static_cast<int>(YASIO_ARRAYSIZE(hosts)); ++index)
+    service.set_option(YOPT_C_LFBFD_PARAMS, index, 65535, -1, 0, 0);
+
+  io_pool pool(service, s_pool_first, s_pool_size);
+
+  std::mutex mtx;
+  std::string echoed;
+  std::atomic<int> lost_channel(-1);
+  service.start_service([&](event_ptr&& event) {
+    if (pool.on_event(event))
+    {
+      if (event->kind() == YEK_CONNECTION_LOST)
+        lost_channel = event->cindex();
+      return;
+    }
+    if (event->kind() != YEK_PACKET)
+      return;
+    auto& packet = event->packet();
+    if (event->cindex() == 0)
+    { // the server echoes, or drops the connection on request
+      if (packet.size() == 4 && memcmp(packet.data(), "drop", 4) == 0)
+        service.close(event->transport());
+      else
+        service.write(event->transport(), std::move(packet));
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lck(mtx);
+      echoed.append(packet.data(), packet.size());
+    }
+  });
+  service.open(0, YCK_TCP_SERVER);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  bool ok = true;
+  auto check = [&](bool value, const char* what) {
+    printf("[io_pool] %s: %s\n", what, value ? "ok" : "failed");
+    ok = ok && value;
+    return value;
+  };
+
+  // warmup --> acquire --> release
+  pool.warmup(s_warmup);
+  check(wait_until([&] { return pool.idle_count() == s_warmup; }), "warmup");
+
+  auto transport = pool.acquire();
+  if (check(transport != nullptr, "acquire"))
+  {
+    service.write(transport, "hello", 5);
+    check(wait_until([&] {
+            std::lock_guard<std::mutex> lck(mtx);
+            return echoed == "hello";
+          }),
+          "echo");
+    pool.release(transport);
+    // the acquire opened another channel to keep warmup idle transports
+    check(wait_until([&] { return pool.idle_count() == s_warmup + 1; }), "release");
+
+    // the same idle transport is checked out again without reconnect
+    check(pool.acquire() == transport, "reuse");
+    pool.release(transport);
+  }
+
+  // the connection lost when checked out, the handle is stale after YEK_CONNECTION_LOST
+  transport = pool.acquire();
+  if (check(transport != nullptr, "acquire to lose"))
+  {
+    int cindex = transport->cindex();
+    service.write(transport, "drop", 4);
+    check(wait_until([&] { return lost_channel == cindex; }), "lost");
+    pool.release(transport); // must not touch the deallocated transport
+    pool.release(nullptr);
+    check(wait_until([&] { return pool.idle_count() == s_warmup; }), "replenish");
+
+    auto another = pool.acquire();
+    check(another != nullptr, "acquire after lost");
+    pool.release(another, false); // closed, and reopened to keep warmup
+    check(wait_until([&] { return pool.idle_count() == s_warmup; }), "release not reusable");
+  }
+
+  service.stop_service();
+  printf("[io_pool] %s\n", ok ? "passed" : "failed");
+  return ok ? 0 : 1;
+}
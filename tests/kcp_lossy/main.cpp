@@ -0,0 +1,229 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <random>
+
+#define YASIO_HAVE_KCP 1
+#define YASIO_HEADER_ONLY 1
+
+#include "yasio/yasio.hpp"
+#include "yasio/ibstream.hpp"
+#include "yasio/obstream.hpp"
+
+using namespace yasio;
+using namespace yasio::inet;
+
+// The lossy link benchmark: sender --> link --> receiver, and the acks go back the same way.
+// Reports the latency percentiles of fixed/adaptive window, with and without fec, of the paced
+// messages and of a burst which saturates the link, the adaptive window only grows when the
+// sender is backlogged.
+// usage: kcplossytest [loss:int(10)] [delay:int(40)]
+static const int s_message_size     = 1000; // bytes per message
+static const int s_send_duration    = 5;    // seconds
+static const int s_burst_messages   = 5000; // messages written at once by the saturating case
+static const int s_drain_timeout    = 10;   // seconds to wait the receiver after send finished
+static const int s_adaptive_max_wnd = 1024;
+static const int s_fec_data_shards  = 10;
+static const int s_fec_parity       = 3;
+
+// The link emulator, drops 'loss' percent of datagrams and delays the rest 'delay' milliseconds
+// in both directions.
+class lossy_link
+{
+  struct packet
+  {
+    long long due;
+    int from;
+    std::vector<char> data;
+  };
+
+public:
+  lossy_link(u_short sender_side_port, const ip::endpoint& sender, u_short receiver_side_port,
+             const ip::endpoint& receiver, int loss, int delay)
+      : loss_(loss), delay_(delay), rng_(20200314)
+  {
+    socks_[0].open(AF_INET, SOCK_DGRAM);
+    socks_[0].bind("127.0.0.1", sender_side_port);
+    socks_[1].open(AF_INET, SOCK_DGRAM);
+    socks_[1].bind("127.0.0.1", receiver_side_port);
+    peers_[0] = sender;
+    peers_[1] = receiver;
+  }
+
+  void start()
+  {
+    stopping_ = false;
+    worker_   = std::thread(&lossy_link::run, this);
+  }
+
+  void stop()
+  {
+    stopping_ = true;
+    if (worker_.joinable())
+      worker_.join();
+  }
+
+  int dropped() const { return dropped_; }
+
+private:
+  void run()
+  {
+    char buf[YASIO_INET_BUFFER_SIZE];
+    while (!stopping_)
+    {
+      long long wait_duration = 10000; // 10ms at most, so we can check the stop flag
+      if (!queue_.empty())
+        wait_duration =
+            (std::max)(0LL, (std::min)(wait_duration, queue_.front().due - highp_clock()));
+
+      fd_set readfds;
+      FD_ZERO(&readfds);
+      FD_SET(socks_[0].native_handle(), &readfds);
+      FD_SET(socks_[1].native_handle(), &readfds);
+      timeval tv = {(decltype(timeval::tv_sec))(wait_duration / 1000000),
+                    (decltype(timeval::tv_usec))(wait_duration % 1000000)};
+      int maxfd  = (int)(std::max)(socks_[0].native_handle(), socks_[1].native_handle()) + 1;
+      if (::select(maxfd, &readfds, nullptr, nullptr, &tv) > 0)
+      {
+        for (int i = 0; i < 2; ++i)
+        {
+          if (!FD_ISSET(socks_[i].native_handle(), &readfds))
+            continue;
+          ip::endpoint from;
+          int n = socks_[i].recvfrom(buf, sizeof(buf), from);
+          if (n <= 0)
+            continue;
+          if (static_cast<int>(rng_() % 100) < loss_)
+            ++dropped_;
+          else
+            queue_.push_back(packet{highp_clock() + delay_ * 1000LL, i,
+                                    std::vector<char>(buf, buf + n)});
+        }
+      }
+
+      // deliver the due packets to the other side
+      auto now = highp_clock();
+      while (!queue_.empty() && queue_.front().due <= now)
+      {
+        auto& pkt = queue_.front();
+        int to    = 1 - pkt.from;
+        socks_[to].sendto(pkt.data.data(), static_cast<int>(pkt.data.size()), peers_[to]);
+        queue_.pop_front();
+      }
+    }
+  }
+
+  xxsocket socks_[2];
+  ip::endpoint peers_[2];
+  std::deque<packet> queue_;
+  int loss_;
+  int delay_;
+  int dropped_ = 0;
+  std::mt19937 rng_;
+  std::atomic<bool> stopping_;
+  std::thread worker_;
+};
+
+void run_benchmark(const char* title, int max_wnd, int fec_parity, u_short base_port, int loss,
+                   int delay, bool burst = false)
+{
+  u_short sender_port = base_port, link_sender_port = base_port + 1,
+          link_receiver_port = base_port + 2, receiver_port = base_port + 3;
+
+  lossy_link link(link_sender_port, ip::endpoint("127.0.0.1", sender_port), link_receiver_port,
+                  ip::endpoint("127.0.0.1", receiver_port), loss, delay);
+  link.start();
+
+  io_hostent sender_ep("127.0.0.1", link_sender_port);
+  io_hostent receiver_ep("127.0.0.1", link_receiver_port);
+  io_service sender(&sender_ep, 1), receiver(&receiver_ep, 1);
+
+  std::vector<long long> latencies;
+  std::atomic<int> received(0);
+  receiver.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  receiver.set_option(YOPT_C_LOCAL_PORT, 0, receiver_port);
+  receiver.set_option(YOPT_C_KCP_ADAPTIVE, 0, max_wnd);
+  receiver.set_option(YOPT_C_KCP_FEC, 0, s_fec_data_shards, fec_parity);
+  receiver.start_service([&](event_ptr event) {
+    if (event->kind() == YEK_PACKET)
+    {
+      ibstream_view ibs(event->packet().data(), static_cast<int>(event->packet().size()));
+      latencies.push_back(highp_clock() - ibs.read_i<int64_t>());
+      ++received;
+    }
+  });
+  receiver.open(0, YCK_KCP_CLIENT);
+
+  std::atomic<transport_handle_t> thandle(nullptr);
+  sender.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  sender.set_option(YOPT_C_LOCAL_PORT, 0, sender_port);
+  sender.set_option(YOPT_C_KCP_ADAPTIVE, 0, max_wnd);
+  sender.set_option(YOPT_C_KCP_FEC, 0, s_fec_data_shards, fec_parity);
+  sender.start_service([&](event_ptr event) {
+    if (event->kind() == YEK_CONNECT_RESPONSE && event->status() == 0)
+      thandle = event->transport();
+  });
+  sender.open(0, YCK_KCP_CLIENT);
+
+  while (!thandle)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  auto send_message = [&] {
+    obstream obs(s_message_size);
+    obs.write_i<int64_t>(highp_clock());
+    obs.buffer().resize(s_message_size);
+    sender.write(thandle, std::move(obs.buffer()));
+  };
+
+  // send one message every millisecond, or all messages of burst without pacing
+  int sent        = 0;
+  auto time_start = highp_clock();
+  if (burst)
+  {
+    for (; sent < s_burst_messages; ++sent)
+      send_message();
+  }
+  else
+  {
+    auto send_end = time_start + s_send_duration * 1000000LL;
+    for (; highp_clock() < send_end; ++sent)
+    {
+      send_message();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  auto drain_end = highp_clock() + s_drain_timeout * 1000000LL;
+  while (received < sent && highp_clock() < drain_end)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  auto time_elapsed = (highp_clock() - time_start) / 1000000.0;
+
+  sender.stop_service();
+  receiver.stop_service();
+  link.stop();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) -> double {
+    return latencies.empty() ? 0 : latencies[(size_t)(p * (latencies.size() - 1))] / 1000.0;
+  };
+  printf("[%s] loss:%d%%, delay:%dms, sent:%d, received:%d, dropped datagrams:%d, "
+         "speed:%.1lfKB/s, latency(ms) p50:%.1lf, p99:%.1lf, max:%.1lf\n",
+         title, loss, delay, sent, (int)received, link.dropped(),
+         received * (double)s_message_size / 1024 / time_elapsed, percentile(0.5),
+         percentile(0.99), percentile(1));
+}
+
+int main(int argc, char** argv)
+{
+  int loss  = argc > 1 ? atoi(argv[1]) : 10;
+  int delay = argc > 2 ? atoi(argv[2]) : 40;
+
+  run_benchmark("fixed", 0, 0, 30101, loss, delay);
+  run_benchmark("adaptive", s_adaptive_max_wnd, 0, 30111, loss, delay);
+  run_benchmark("fixed+fec", 0, s_fec_parity, 30121, loss, delay);
+  run_benchmark("adaptive+fec", s_adaptive_max_wnd, s_fec_parity, 30131, loss, delay);
+  run_benchmark("fixed burst", 0, 0, 30141, loss, delay, true);
+  run_benchmark("adaptive burst", s_adaptive_max_wnd, 0, 30151, loss, delay, true);
+  return 0;
+}
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasio/yasio.hpp"
+
+using namespace yasio;
+using namespace yasio::inet;
+
+// The resolve storm test: 200 client channels with the distinct host names resolve at once by
+// the resolver thread pool (YOPT_S_RESOLV_THREADS), the fake resolver maps them to the echo
+// server at channel 0. Checks the resolver threads are bounded, each host resolved once and each
+// channel connected once. Then disposes the service while the resolving tasks are still queued,
+// the queued tasks must be dropped without run.
+// usage: resolvstormtest [port:int(30711)]
+static const int s_storm_size     = 200;
+static const int s_resolv_threads = 3;
+static const int s_queued_size    = 20;
+
+template <typename _Pred> static bool wait_until(_Pred pred, int timeout_ms = 10000)
+{
+  for (int elapsed = 0; elapsed < timeout_ms; elapsed += 10)
+  {
+    if (pred())
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return pred();
+}
+
+// The fake resolver records the threads and the concurrent calls
+class storm_resolver
+{
+public:
+  storm_resolver(u_short port, int cost_ms) : port_(port), cost_ms_(cost_ms) {}
+
+  int operator()(std::vector<ip::endpoint>& endpoints, const char* hostname, unsigned short)
+  {
+    int running = ++running_;
+    {
+      std::lock_guard<std::mutex> lck(mtx_);
+      threads_.insert(std::this_thread::get_id());
+      ++calls_[hostname];
+      if (running > max_running_)
+        max_running_ = running;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(cost_ms_));
+    endpoints.push_back(ip::endpoint("127.0.0.1", port_));
+    --running_;
+    return 0;
+  }
+
+  int thread_count()
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return static_cast<int>(threads_.size());
+  }
+  int max_running()
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return max_running_;
+  }
+  std::map<std::string, int> calls()
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return calls_;
+  }
+
+private:
+  u_short port_;
+  int cost_ms_;
+  std::atomic<int> running_{0};
+  std::mutex mtx_;
+  std::set<std::thread::id> threads_;
+  std::map<std::string, int> calls_;
+  int max_running_ = 0;
+};
+
+static void add_hosts(std::vector<io_hostent>& hosts, const char* prefix, int count, u_short port)
+{
+  char name[64];
+  for (int index = 0; index < count; ++index)
+  {
+    snprintf(name, sizeof(name), "%s%d.resolv.test", prefix, index);
+    hosts.push_back(io_hostent(name, port));
+  }
+}
+
+static bool run_storm_test(u_short port)
+{
+  bool ok    = true;
+  auto check = [&](bool value, const char* what) {
+    printf("[resolv storm] %s: %s\n", what, value ? "ok" : "failed");
+    ok = ok && value;
+  };
+
+  std::vector<io_hostent> hosts;
+  hosts.push_back(io_hostent("127.0.0.1", port)); // the server at channel 0
+  add_hosts(hosts, "storm", s_storm_size, port);
+  io_service service(hosts.data(), static_cast<int>(hosts.size()));
+
+  storm_resolver resolver(port, 2);
+  resolv_fn_t resolv = std::ref(resolver);
+  service.set_option(YOPT_S_RESOLV_FN, &resolv);
+  service.set_option(YOPT_S_RESOLV_THREADS, s_resolv_threads);
+  service.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  service.set_option(YOPT_C_MOD_FLAGS, 0, YCF_REUSEADDR, 0);
+
+  std::vector<int> responses(hosts.size());
+  std::atomic<int> connected(0), failed(0);
+  service.start_service([&](event_ptr&& event) {
+    if (event->kind() != YEK_CONNECT_RESPONSE || event->cindex() == 0)
+      return;
+    ++responses[event->cindex()];
+    if (event->status() == 0)
+      ++connected;
+    else
+      ++failed;
+  });
+  service.open(0, YCK_TCP_SERVER);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  for (int index = 1; index <= s_storm_size; ++index)
+    service.open(index, YCK_TCP_CLIENT);
+  check(wait_until([&] { return connected + failed >= s_storm_size; }), "all completed");
+  std::this_thread::sleep_for(std::chrono::milliseconds(200)); // the duplicated completions
+  service.stop_service();
+
+  int once = 0;
+  for (int index = 1; index <= s_storm_size; ++index)
+    once += responses[index] == 1 ? 1 : 0;
+  check(once == s_storm_size, "exactly one completion per channel");
+  check(connected == s_storm_size, "all connected");
+
+  auto calls   = resolver.calls();
+  int resolved = 0;
+  for (auto& call : calls)
+    resolved += call.second == 1 ? 1 : 0;
+  check(resolved == s_storm_size && static_cast<int>(calls.size()) == s_storm_size,
+        "each host resolved once");
+
+  printf("[resolv storm] threads=%d, max running=%d\n", resolver.thread_count(),
+         resolver.max_running());
+  check(resolver.thread_count() <= s_resolv_threads, "threads bounded");
+  check(resolver.max_running() <= s_resolv_threads, "concurrent resolves bounded");
+  return ok;
+}
+
+static bool run_dispose_test(u_short port)
+{
+  bool ok    = true;
+  auto check = [&](bool value, const char* what) {
+    printf("[resolv storm] %s: %s\n", what, value ? "ok" : "failed");
+    ok = ok && value;
+  };
+
+  // the slow resolver with one thread, the most of tasks are queued
+  const int cost_ms = 200;
+  storm_resolver resolver(port, cost_ms);
+  auto time_start = highp_clock();
+  {
+    std::vector<io_hostent> hosts;
+    add_hosts(hosts, "queued", s_queued_size, port);
+    io_service service(hosts.data(), s_queued_size);
+    resolv_fn_t resolv = std::ref(resolver);
+    service.set_option(YOPT_S_RESOLV_FN, &resolv);
+    service.set_option(YOPT_S_RESOLV_THREADS, 1);
+    service.start_service([](event_ptr&&) {});
+    for (int index = 0; index < s_queued_size; ++index)
+      service.open(index, YCK_TCP_CLIENT);
+    check(wait_until([&] { return !resolver.calls().empty(); }), "resolving");
+  } // stop and dispose, the thread pool joins the running task and drops the queued tasks
+  auto elapsed_ms = (highp_clock() - time_start) / 1000;
+
+  auto calls = resolver.calls().size();
+  std::this_thread::sleep_for(std::chrono::milliseconds(cost_ms * 2));
+  check(calls < static_cast<size_t>(s_queued_size), "queued tasks dropped");
+  check(resolver.calls().size() == calls, "no task runs after dispose");
+  check(elapsed_ms < cost_ms * s_queued_size / 2, "dispose not wait the queued tasks");
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+#if !defined(YASIO_HAVE_CARES)
+  u_short port = static_cast<u_short>(argc > 1 ? atoi(argv[1]) : 30711);
+
+  bool ok = run_storm_test(port);
+  ok      = run_dispose_test(port) && ok;
+  printf("[resolv storm] %s\n", ok ? "passed" : "failed");
+  return ok ? 0 : 1;
+#else
+  (void)argc;
+  (void)argv;
+  printf("[resolv storm] the resolver thread pool not used with c-ares, skipped\n");
+  return 0;
+#endif
+}
@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "yasio/yasio.hpp"
+
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+
+using namespace yasio;
+using namespace yasio::inet;
+
+// The ssl reconnect benchmark: connects a local OpenSSL server again and again, and reports the
+// handshake latency with and without the session resumption, then sends 'mbytes' to the server and
+// reports the throughput of userspace tls and kernel tls(falls back to userspace if unavailable).
+// usage: sslperftest [count:int(200)] [mbytes:int(256)]
+static const u_short s_server_port = 30301;
+static const int s_chunk_size      = 64 * 1024;
+static const int s_inflight_chunks = 4;
+
+// Generates a self-signed P-256 certificate in memory, so the test doesn't need any pem files
+static bool make_self_signed_cert(EVP_PKEY*& pkey, X509*& cert)
+{
+  auto kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+  pkey      = nullptr;
+  cert      = nullptr;
+  if (EVP_PKEY_keygen_init(kctx) <= 0 ||
+      EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) <= 0 ||
+      EVP_PKEY_keygen(kctx, &pkey) <= 0)
+  {
+    EVP_PKEY_CTX_free(kctx);
+    return false;
+  }
+  EVP_PKEY_CTX_free(kctx);
+
+  cert = X509_new();
+  X509_set_version(cert, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+  X509_set_pubkey(cert, pkey);
+  auto name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1,
+                             0);
+  X509_set_issuer_name(cert, name);
+  return X509_sign(cert, pkey, EVP_sha256()) > 0;
+}
+
+// The blocking OpenSSL server, serves 'count' connections one by one: handshake, sends a hello,
+// and reads until the client close.
+class ssl_server
+{
+public:
+  bool start(int count)
+  {
+    EVP_PKEY* pkey;
+    X509* cert;
+    if (!make_self_signed_cert(pkey, cert))
+      return false;
+    ssl_ctx_ = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_use_certificate(ssl_ctx_, cert);
+    SSL_CTX_use_PrivateKey(ssl_ctx_, pkey);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+
+    if (listener_.pserv("127.0.0.1", s_server_port) != 0)
+      return false;
+    worker_ = std::thread(&ssl_server::run, this, count);
+    return true;
+  }
+
+  void stop()
+  {
+    if (worker_.joinable())
+      worker_.join();
+    listener_.close();
+    SSL_CTX_free(ssl_ctx_);
+  }
+
+  int resumed() const { return resumed_; }
+  long long bytes() const { return bytes_; }
+  long long elapsed() const { return elapsed_; }
+  int served() const { return served_; }
+  void reset_stats()
+  {
+    resumed_ = 0;
+    bytes_   = 0;
+    elapsed_ = 0;
+  }
+
+private:
+  void run(int count)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      xxsocket client = listener_.accept();
+      if (!client.is_open())
+        break;
+      auto ssl = SSL_new(ssl_ctx_);
+      SSL_set_fd(ssl, static_cast<int>(client.native_handle()));
+      if (SSL_accept(ssl) == 1)
+      {
+        if (SSL_session_reused(ssl))
+          ++resumed_;
+        SSL_write(ssl, "hello", 5);
+        auto time_start = highp_clock();
+        int n;
+        while ((n = SSL_read(ssl, buf_, sizeof(buf_))) > 0)
+          bytes_ += n;
+        elapsed_ += highp_clock() - time_start;
+      }
+      SSL_free(ssl);
+      ++served_;
+    }
+  }
+
+  SSL_CTX* ssl_ctx_ = nullptr;
+  xxsocket listener_;
+  std::thread worker_;
+  std::atomic<int> served_{0};
+  std::atomic<int> resumed_{0};
+  std::atomic<long long> bytes_{0};
+  std::atomic<long long> elapsed_{0};
+  char buf_[s_chunk_size];
+};
+
+void run_benchmark(const char* title, bool session_cache, int count, ssl_server& server)
+{
+  io_hostent ep("127.0.0.1", s_server_port);
+  io_service service(&ep, 1);
+
+  std::vector<long long> latencies;
+  std::atomic<int> completed(0);
+  std::atomic<long long> time_start(0);
+  service.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  service.set_option(YOPT_S_SSL_SESSION_CACHE, session_cache ? 1 : 0);
+  service.start_service([&](event_ptr event) {
+    switch (event->kind())
+    {
+      case YEK_CONNECT_RESPONSE:
+        if (event->status() == 0)
+          latencies.push_back(highp_clock() - time_start);
+        else
+          ++completed;
+        break;
+      case YEK_PACKET: // the hello arrives after the session tickets, so close now
+        service.close(event->transport());
+        break;
+      case YEK_CONNECTION_LOST:
+        ++completed;
+        break;
+    }
+  });
+
+  server.reset_stats();
+  for (int i = 0; i < count; ++i)
+  {
+    time_start = highp_clock();
+    service.open(0, YCK_SSL_CLIENT);
+    while (completed <= i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  service.stop_service();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) -> double {
+    return latencies.empty() ? 0 : latencies[(size_t)(p * (latencies.size() - 1))] / 1000.0;
+  };
+  printf("[%s] connected:%d/%d, resumed:%d, handshake latency(ms) p50:%.3lf, p99:%.3lf\n", title,
+         (int)latencies.size(), count, server.resumed(), percentile(0.5), percentile(0.99));
+}
+
+void run_throughput(const char* title, bool ktls, int mbytes, ssl_server& server)
+{
+  io_hostent ep("127.0.0.1", s_server_port);
+  io_service service(&ep, 1);
+
+  long long total = mbytes * 1024LL * 1024;
+  long long sent  = 0;
+  long long acked = 0;
+  std::atomic<bool> completed(false);
+  std::function<void(transport_handle_t)> send_chunk = [&](transport_handle_t thandle) {
+    if (sent >= total)
+      return;
+    sent += s_chunk_size;
+    service.write(thandle, std::vector<char>(s_chunk_size, 'x'), [&, thandle]() {
+      acked += s_chunk_size;
+      if (sent < total)
+        send_chunk(thandle);
+      else if (acked >= total)
+        service.close(thandle); // the server reads until the close notify
+    });
+  };
+  service.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  service.set_option(YOPT_S_SSL_KTLS, ktls ? 1 : 0);
+  service.start_service([&](event_ptr event) {
+    switch (event->kind())
+    {
+      case YEK_CONNECT_RESPONSE:
+        if (event->status() == 0)
+        {
+          for (int i = 0; i < s_inflight_chunks; ++i)
+            send_chunk(event->transport());
+        }
+        else
+          completed = true;
+        break;
+      case YEK_CONNECTION_LOST:
+        completed = true;
+        break;
+    }
+  });
+
+  server.reset_stats();
+  int served = server.served();
+  service.open(0, YCK_SSL_CLIENT);
+  while (!completed || server.served() == served)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  service.stop_service();
+
+  auto seconds = server.elapsed() / 1000000.0;
+  printf("[%s] received:%lld/%lld bytes, speed:%.1lfMB/s\n", title, server.bytes(), total,
+         seconds > 0 ? server.bytes() / 1024.0 / 1024 / seconds : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+  int count  = argc > 1 ? atoi(argv[1]) : 200;
+  int mbytes = argc > 2 ? atoi(argv[2]) : 256;
+
+  ssl_server server;
+  if (!server.start(count * 2 + 2))
+  {
+    printf("start ssl server failed!\n");
+    return -1;
+  }
+
+  run_benchmark("full handshake", false, count, server);
+  run_benchmark("session resumption", true, count, server);
+  run_throughput("userspace tls", false, mbytes, server);
+  run_throughput("kernel tls", true, mbytes, server);
+
+  server.stop();
+  return 0;
+}
@@ -0,0 +1,325 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasio/yasio.hpp"
+
+#include <openssl/ssl.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+
+using namespace yasio;
+using namespace yasio::inet;
+
+// The in-process ssl server test: YCK_SSL_SERVER with a self-signed certificate serves a
+// YCK_SSL_CLIENT over loopback. Checks the handshake completes and a message echoes, the stalled
+// client which never handshakes is dropped at the accept timeout, and the pending handshakes are
+// dropped when the server channel closes. Then storms the server with the concurrent handshakes
+// while an established connection echoes, reports the p99 latency of it with the handshakes at
+// the event loop thread and at YOPT_S_SSL_HANDSHAKE_THREADS, closes the server channel in the
+// storm to drop the handshakes running at the thread pool.
+// usage: sslservertest [storm:int(64)] [seconds:int(2)]
+static const u_short s_server_port   = 30321;
+static const int s_accept_timeout    = 1; // seconds, see YOPT_S_CONNECT_TIMEOUT
+static const char* s_cert_file       = "sslservertest_cert.pem";
+static const char* s_key_file        = "sslservertest_key.pem";
+
+// Generates a self-signed P-256 certificate, and saves it with the private key to pem files
+static bool make_self_signed_cert_files()
+{
+  auto kctx      = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+  EVP_PKEY* pkey = nullptr;
+  if (EVP_PKEY_keygen_init(kctx) <= 0 ||
+      EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) <= 0 ||
+      EVP_PKEY_keygen(kctx, &pkey) <= 0)
+  {
+    EVP_PKEY_CTX_free(kctx);
+    return false;
+  }
+  EVP_PKEY_CTX_free(kctx);
+
+  auto cert = X509_new();
+  X509_set_version(cert, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+  X509_set_pubkey(cert, pkey);
+  auto name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1,
+                             0);
+  X509_set_issuer_name(cert, name);
+
+  bool ok = X509_sign(cert, pkey, EVP_sha256()) > 0;
+  if (ok)
+  {
+    auto fp = fopen(s_cert_file, "wb");
+    ok      = fp && PEM_write_X509(fp, cert) == 1;
+    if (fp)
+      fclose(fp);
+  }
+  if (ok)
+  {
+    auto fp = fopen(s_key_file, "wb");
+    ok      = fp && PEM_write_PrivateKey(fp, pkey, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+    if (fp)
+      fclose(fp);
+  }
+  X509_free(cert);
+  EVP_PKEY_free(pkey);
+  return ok;
+}
+
+template <typename _Pred> static bool wait_until(_Pred pred, int timeout_ms)
+{
+  for (int elapsed = 0; elapsed < timeout_ms; elapsed += 5)
+  {
+    if (pred())
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return pred();
+}
+
+// Waits the server close the connection, returns the milliseconds waited, -1 if not closed
+static int wait_closed(xxsocket& sock, int timeout_ms)
+{
+  char c;
+  auto time_start = highp_clock();
+  sock.set_nonblocking(true);
+  bool closed = wait_until([&] { return sock.recv(&c, 1) == 0; }, timeout_ms);
+  return closed ? static_cast<int>((highp_clock() - time_start) / 1000) : -1;
+}
+
+// The echo server, reports the established connections only
+class echo_server
+{
+public:
+  echo_server(int handshake_threads) : service_(io_hostent("127.0.0.1", s_server_port))
+  {
+    service_.set_option(YOPT_S_DEFERRED_EVENT, 0);
+    service_.set_option(YOPT_S_CONNECT_TIMEOUT, s_accept_timeout);
+    service_.set_option(YOPT_S_SSL_HANDSHAKE_THREADS, handshake_threads);
+    service_.set_option(YOPT_S_SSL_CERT, s_cert_file, s_key_file);
+    service_.set_option(YOPT_C_MOD_FLAGS, 0, YCF_REUSEADDR, 0);
+    service_.set_option(YOPT_C_LFBFD_PARAMS, 0, 65535, -1, 0, 0);
+    service_.start_service([this](event_ptr event) {
+      switch (event->kind())
+      {
+        case YEK_CONNECT_RESPONSE:
+          if (event->status() == 0)
+            ++established_;
+          break;
+        case YEK_PACKET:
+          service_.write(event->transport(), std::move(event->packet()));
+          break;
+      }
+    });
+    service_.open(0, YCK_SSL_SERVER);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  ~echo_server() { service_.stop_service(); }
+
+  io_service& service() { return service_; }
+  int established() const { return established_; }
+
+private:
+  io_service service_;
+  std::atomic<int> established_{0};
+};
+
+// Connects the server with YCK_SSL_CLIENT, returns true if the message echoes back
+static bool ssl_echo(const std::string& message)
+{
+  io_service client(io_hostent("127.0.0.1", s_server_port));
+  std::string echoed;
+  std::atomic<bool> echo_done(false);
+  client.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  client.set_option(YOPT_C_LFBFD_PARAMS, 0, 65535, -1, 0, 0);
+  client.start_service([&](event_ptr event) {
+    switch (event->kind())
+    {
+      case YEK_CONNECT_RESPONSE:
+        if (event->status() == 0)
+          client.write(event->transport(), message.data(), message.size());
+        break;
+      case YEK_PACKET:
+        echoed.append(event->packet().data(), event->packet().size());
+        echo_done = echoed.size() >= message.size();
+        break;
+    }
+  });
+  client.open(0, YCK_SSL_CLIENT);
+  bool ok = wait_until([&] { return echo_done.load(); }, 3000) && echoed == message;
+  client.stop_service();
+  return ok;
+}
+
+static bool run_handshake_test()
+{
+  bool ok    = true;
+  auto check = [&](bool value, const char* what) {
+    printf("[ssl server] %s: %s\n", what, value ? "ok" : "failed");
+    ok = ok && value;
+  };
+
+  echo_server server(0);
+
+  // the handshake completes and the message echoes back
+  check(ssl_echo("ping"), "echo");
+  check(server.established() == 1, "handshake");
+
+  // the stalled client never handshakes, it's dropped at the accept timeout without reported
+  xxsocket stalled;
+  stalled.xpconnect("127.0.0.1", s_server_port);
+  int waited = wait_closed(stalled, (s_accept_timeout + 2) * 1000);
+  check(waited >= 0, "stalled dropped at the accept timeout");
+  check(waited >= s_accept_timeout * 1000 - 100, "stalled kept until the accept timeout");
+  check(server.established() == 1, "stalled not reported");
+
+  // the pending handshakes are dropped when the server channel closes
+  xxsocket pending;
+  pending.xpconnect("127.0.0.1", s_server_port);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  server.service().close(0);
+  check(wait_closed(pending, 500) >= 0, "pending dropped at close");
+  return ok;
+}
+
+// The storm clients handshake and disconnect repeatedly, meanwhile the established connection
+// echoes the timestamps one by one, reports the p99 round trip latency of it.
+static bool run_storm_test(int handshake_threads, int storm_size, int seconds)
+{
+  bool ok    = true;
+  auto check = [&](bool value, const char* what) {
+    printf("[ssl server] threads=%d, %s: %s\n", handshake_threads, what, value ? "ok" : "failed");
+    ok = ok && value;
+  };
+
+  echo_server server(handshake_threads);
+
+  // the established connection
+  io_service probe(io_hostent("127.0.0.1", s_server_port));
+  std::vector<highp_time_t> latencies;
+  std::string echoed;
+  std::atomic<bool> probing(true);
+  auto send_timestamp = [&](transport_handle_t transport) {
+    auto now = highp_clock();
+    probe.write(transport, &now, sizeof(now));
+  };
+  probe.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  probe.set_option(YOPT_C_LFBFD_PARAMS, 0, 65535, -1, 0, 0);
+  probe.start_service([&](event_ptr event) {
+    switch (event->kind())
+    {
+      case YEK_CONNECT_RESPONSE:
+        if (event->status() == 0)
+          send_timestamp(event->transport());
+        break;
+      case YEK_PACKET:
+        echoed.append(event->packet().data(), event->packet().size());
+        if (echoed.size() >= sizeof(highp_time_t))
+        {
+          highp_time_t timestamp;
+          memcpy(&timestamp, echoed.data(), sizeof(timestamp));
+          echoed.erase(0, sizeof(timestamp));
+          latencies.push_back(highp_clock() - timestamp);
+          if (probing)
+            send_timestamp(event->transport());
+        }
+        break;
+    }
+  });
+  probe.open(0, YCK_SSL_CLIENT);
+  check(wait_until([&] { return server.established() == 1; }, 3000), "probe established");
+
+  // the storm clients
+  std::vector<io_hostent> hosts(storm_size, io_hostent("127.0.0.1", s_server_port));
+  io_service storm(hosts.data(), storm_size);
+  std::atomic<bool> storming(true);
+  std::atomic<int> handshakes(0);
+  print_fn_t quiet = [](const char*) {}; // the refused reconnects when the server closed
+  storm.set_option(YOPT_S_DEFERRED_EVENT, 0);
+  storm.set_option(YOPT_S_PRINT_FN, &quiet);
+  storm.start_service([&](event_ptr event) {
+    switch (event->kind())
+    {
+      case YEK_CONNECT_RESPONSE:
+        if (event->status() == 0)
+        {
+          ++handshakes;
+          storm.close(event->transport());
+        }
+        else if (storming)
+          storm.open(event->cindex(), YCK_SSL_CLIENT);
+        break;
+      case YEK_CONNECTION_LOST:
+        if (storming)
+          storm.open(event->cindex(), YCK_SSL_CLIENT);
+        break;
+    }
+  });
+  for (int index = 0; index < storm_size; ++index)
+    storm.open(index, YCK_SSL_CLIENT);
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  probing = false;
+
+  // close the server channel in the storm repeatedly, the handshakes in flight are dropped
+  for (int round = 0; round < 10; ++round)
+  {
+    server.service().close(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    server.service().open(0, YCK_SSL_SERVER);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  storming = false;
+  storm.stop_service();
+  probe.stop_service();
+
+  check(handshakes > 0, "storm handshakes");
+  check(!latencies.empty(), "probe echoes");
+  if (!latencies.empty())
+  {
+    std::sort(latencies.begin(), latencies.end());
+    printf("[ssl server] threads=%d, handshakes=%d, echoes=%d, p99=%lldus\n", handshake_threads,
+           handshakes.load(), static_cast<int>(latencies.size()),
+           static_cast<long long>(latencies[latencies.size() * 99 / 100]));
+  }
+
+  // the server channel reopened without the dropped handshakes
+  check(ssl_echo("pong"), "echo after reopen");
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+  int storm_size = argc > 1 ? atoi(argv[1]) : 64;
+  int seconds    = argc > 2 ? atoi(argv[2]) : 2;
+
+#if !defined(_WIN32)
+  // The openssl socket bio writes the peer closed in the storm
+  signal(SIGPIPE, SIG_IGN);
+#endif
+  SSL_library_init();
+  if (!make_self_signed_cert_files())
+  {
+    printf("generate the self-signed certificate failed!\n");
+    return -1;
+  }
+
+  bool ok = run_handshake_test();
+  ok      = run_storm_test(0, storm_size, seconds) && ok;
+  ok      = run_storm_test(2, storm_size, seconds) && ok;
+  remove(s_cert_file);
+  remove(s_key_file);
+  printf("[ssl server] %s\n", ok ? "passed" : "failed");
+  return ok ? 0 : 1;
+}
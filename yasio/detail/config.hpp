@@ -169,6 +169,52 @@ SOFTWARE.
 // The max Initial Bytes To Strip for length field based frame decode mechanism
 #define YASIO_MAX_IBTS 32
 
+// The max delimiter length for delimiter based frame decode mechanism
+#define YASIO_MAX_DELIMITER 8
+
+// The percent of dns record ttl elapsed before refreshing ahead, so the connects to a frequently
+// used host never wait the resolving.
+#define YASIO_DNS_PREFETCH_PERCENT 90
+
+/*
+** The macros used by kcp adaptive profile, the loss is timeout retransmissions per hundred
+** segments sent in a sample period.
+*/
+// The window never shrinks below this when user doesn't set sndwnd, it's kcp's default.
+#define YASIO_KCP_MIN_WND 32
+// The window grows only when the loss is below this
+#define YASIO_KCP_LOW_LOSS 2
+// The window shrinks when the loss is above this
+#define YASIO_KCP_HIGH_LOSS 10
+
+// The interval in milliseconds of kcp client resending the handshake request
+#define YASIO_KCP_SYN_INTERVAL 200
+
+// The max datagrams of kcp server listening socket demuxed per event loop
+#define YASIO_KCP_MAX_DEMUX 64
+
+// The max kcp handshakes waiting the first segment of clients, the requests beyond it are dropped
+#define YASIO_KCP_MAX_HANDSHAKES 1024
+
+// The default milliseconds a kcp server session can receive nothing before closed
+#define YASIO_KCP_IDLE_TIMEOUT 60000
+
+/*
+** The macros used by udp/kcp path mtu discovery, the sizes are udp payload size.
+*/
+// The size assumed safe before probing, ipv6 minimum mtu 1280 minus headers with some margin
+#define YASIO_PMTUD_BASE 1200
+// The timeout in milliseconds of waiting the probe ack
+#define YASIO_PMTUD_PROBE_TIMEOUT 1000
+// The max times of sending a probe size before regards it too large
+#define YASIO_PMTUD_MAX_PROBES 3
+
+// The max buffers sent by one xxsocket::sendv call, it's the minimum IOV_MAX of posix.
+#define YASIO_MAX_IOV 16
+
+// The blobs smaller than this are copied into the inline buffer of chain_obstream
+#define YASIO_MIN_REF_SIZE 1024
+
 #include "strfmt.hpp"
 
 #endif
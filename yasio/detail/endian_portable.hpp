@@ -30,6 +30,7 @@ SOFTWARE.
 #define YASIO__ENDIAN_PORTABLE_HPP
 
 #include <assert.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 
@@ -117,6 +118,22 @@ inline double ntohd(uint64_t Value)
 #  endif /* ntohd */
 #endif   /* NO_EXTRA_HTON_FUNCTIONS */
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#  define YASIO__BIG_ENDIAN 1
+#endif
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define YASIO__HAS_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define YASIO__HAS_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define YASIO__HAS_NEON 1
+#endif
+
 namespace yasio
 {
 namespace endian
@@ -143,10 +160,156 @@ template <> inline int32_t ntohv(int32_t value) { return htonl(value); }
 
 template <> inline int64_t ntohv(int64_t value) { return htonll(value); }
 
+namespace detail
+{
+// Swaps the byte order of each element of a 16 bytes vector
+template <int _Size> struct simd_bswap;
+template <> struct simd_bswap<2>
+{
+#if defined(YASIO__HAS_AVX2)
+  static __m256i mask()
+  {
+    return _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4,
+                            7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  }
+#endif
+#if defined(YASIO__HAS_SSE2)
+  static __m128i swap(__m128i v)
+  {
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  }
+#elif defined(YASIO__HAS_NEON)
+  static uint8x16_t swap(uint8x16_t v) { return vrev16q_u8(v); }
+#endif
+};
+template <> struct simd_bswap<4>
+{
+#if defined(YASIO__HAS_AVX2)
+  static __m256i mask()
+  {
+    return _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6,
+                            5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  }
+#endif
+#if defined(YASIO__HAS_SSE2)
+  static __m128i swap(__m128i v)
+  { // swap the 16 bits words, then the bytes of words
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return simd_bswap<2>::swap(v);
+  }
+#elif defined(YASIO__HAS_NEON)
+  static uint8x16_t swap(uint8x16_t v) { return vrev32q_u8(v); }
+#endif
+};
+template <> struct simd_bswap<8>
+{
+#if defined(YASIO__HAS_AVX2)
+  static __m256i mask()
+  {
+    return _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2,
+                            1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  }
+#endif
+#if defined(YASIO__HAS_SSE2)
+  static __m128i swap(__m128i v)
+  {
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    return simd_bswap<2>::swap(v);
+  }
+#elif defined(YASIO__HAS_NEON)
+  static uint8x16_t swap(uint8x16_t v) { return vrev64q_u8(v); }
+#endif
+};
+
+template <int _Size> inline void bswap_array(char* dst, const char* src, size_t count)
+{
+  size_t i = 0, bytes = count * _Size;
+#if defined(YASIO__HAS_AVX2)
+  const __m256i mask = simd_bswap<_Size>::mask();
+  for (; i + 32 <= bytes; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, mask));
+  }
+#endif
+#if defined(YASIO__HAS_SSE2)
+  for (; i + 16 <= bytes; i += 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), simd_bswap<_Size>::swap(v));
+  }
+#elif defined(YASIO__HAS_NEON)
+  for (; i + 16 <= bytes; i += 16)
+  {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+    vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), simd_bswap<_Size>::swap(v));
+  }
+#endif
+  for (; i < bytes; i += _Size)
+  {
+    char value[_Size];
+    for (int k = 0; k < _Size; ++k)
+      value[k] = src[i + _Size - 1 - k];
+    ::memcpy(dst + i, value, _Size);
+  }
+}
+} // namespace detail
+
+/*
+** Converts the byte order of 'count' elements between host and network by span, the elements
+** size is _Size, 'dst' and 'src' could be the same, but must not overlap partially.
+*/
+template <int _Size> inline void convert_array(void* dst, const void* src, size_t count)
+{
+#if !defined(YASIO__BIG_ENDIAN)
+  detail::bswap_array<_Size>(static_cast<char*>(dst), static_cast<const char*>(src), count);
+#else
+  if (dst != src)
+    ::memcpy(dst, src, count * _Size);
+#endif
+}
+template <> inline void convert_array<1>(void* dst, const void* src, size_t count)
+{
+  if (dst != src)
+    ::memcpy(dst, src, count);
+}
 } // namespace endian
 
 namespace bits
 {
+// The zigzag mapping of signed integers, the small magnitude values get small varint encoding
+inline uint64_t zigzag_encode(int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+inline int64_t zigzag_decode(uint64_t value)
+{
+  return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+inline uint32_t zigzag_encode32(int32_t value)
+{
+  return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+inline int32_t zigzag_decode32(uint32_t value)
+{
+  return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+// Encodes a LEB128 varint to 'out' which has 10 bytes at least, returns the bytes written
+inline int varint_encode(uint64_t value, char* out)
+{
+  int n = 0;
+  while (value >= 0x80)
+  {
+    out[n++] = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = static_cast<char>(value);
+  return n;
+}
+
 static const unsigned char bits_wmask_table[8][8] = {
     {0xFE /*11111110*/},
     {0xFD /*11111101*/, 0xFC /*11111100*/},
@@ -0,0 +1,286 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2020 HALX99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef YASIO__FEC_HPP
+#define YASIO__FEC_HPP
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "yasio/detail/endian_portable.hpp"
+
+namespace yasio
+{
+/*
+** The XOR parity forward error correction for datagrams.
+** The data shards are grouped, the data shard i of a group is covered by the parity shard
+** (i % parity_shards), so the receiver can recover up to 'parity_shards' consecutive losses of
+** a group without a round trip.
+** The shard layout:
+**   data:   [seq:u32][type:u8][count:u8][size:u16][payload]
+**   parity: [seq:u32][type:u8][count:u8][xor of size:u16 & payload of covered data shards]
+** The count of parity shard is the data shards of the group, the group maybe closed before full
+** by fec_encoder::flush.
+*/
+struct fec_shard
+{
+  enum
+  {
+    header_size = 6, // seq, type, count
+    overhead    = 8, // header & size
+    data        = 0xf1,
+    parity      = 0xf2,
+    max_data    = 32,
+    max_parity  = 16,
+  };
+
+  static uint32_t seq(const char* shard)
+  {
+    uint32_t value;
+    ::memcpy(&value, shard, sizeof(value));
+    return yasio::endian::ntohv(value);
+  }
+  static int type(const char* shard) { return static_cast<uint8_t>(shard[4]); }
+  static int count(const char* shard) { return static_cast<uint8_t>(shard[5]); }
+  static int size(const char* region)
+  {
+    uint16_t value;
+    ::memcpy(&value, region, sizeof(value));
+    return yasio::endian::ntohv(value);
+  }
+  static void write_header(char* shard, uint32_t seq, int type, int count)
+  {
+    seq = yasio::endian::htonv(seq);
+    ::memcpy(shard, &seq, sizeof(seq));
+    shard[4] = static_cast<char>(type);
+    shard[5] = static_cast<char>(count);
+  }
+
+  // Gets the payload of a data shard, nullptr if not a valid data shard
+  static const char* payload(const char* shard, int len, int& size)
+  {
+    if (len < overhead || type(shard) != data)
+      return nullptr;
+    size = fec_shard::size(shard + header_size);
+    return size <= len - overhead ? shard + overhead : nullptr;
+  }
+};
+
+class fec_encoder
+{
+public:
+  void reset(int data_shards, int parity_shards)
+  {
+    data_shards_   = data_shards;
+    parity_shards_ = parity_shards;
+    group_seq_     = 0;
+    count_         = 0;
+    parity_.assign(parity_shards, std::vector<char>());
+  }
+  bool enabled() const { return parity_shards_ > 0; }
+
+  // Sends a datagram as data shard, and the parity shards when the group is full
+  template <typename _Fty> void encode(const char* data, int len, _Fty&& output)
+  {
+    scratch_.resize(len + fec_shard::overhead);
+    auto shard = &scratch_.front();
+    fec_shard::write_header(shard, group_seq_ + count_, fec_shard::data, 0);
+    uint16_t size = yasio::endian::htonv(static_cast<uint16_t>(len));
+    ::memcpy(shard + fec_shard::header_size, &size, sizeof(size));
+    ::memcpy(shard + fec_shard::overhead, data, len);
+
+    // accumulate size & payload to the parity shard which covers it
+    auto& parity = parity_[count_ % parity_shards_];
+    auto region  = len + fec_shard::overhead - fec_shard::header_size;
+    if (static_cast<int>(parity.size()) < region + fec_shard::header_size)
+      parity.resize(region + fec_shard::header_size);
+    for (int i = 0; i < region; ++i)
+      parity[fec_shard::header_size + i] ^= shard[fec_shard::header_size + i];
+
+    output(shard, len + fec_shard::overhead);
+
+    if (++count_ == data_shards_)
+      flush(output);
+  }
+
+  // Sends the parity shards of current group and starts a new group, call it at the end of a
+  // burst, so the tail losses can be recovered without waiting more data.
+  template <typename _Fty> void flush(_Fty&& output)
+  {
+    if (count_ == 0)
+      return;
+    for (int i = 0; i < parity_shards_ && i < count_; ++i)
+    {
+      auto& parity = parity_[i];
+      fec_shard::write_header(&parity.front(), group_seq_ + data_shards_ + i, fec_shard::parity,
+                              count_);
+      output(&parity.front(), static_cast<int>(parity.size()));
+      parity.clear();
+    }
+    group_seq_ += data_shards_ + parity_shards_;
+    count_ = 0;
+  }
+
+private:
+  int data_shards_   = 0;
+  int parity_shards_ = 0;
+  uint32_t group_seq_;
+  int count_;
+  std::vector<std::vector<char>> parity_;
+  std::vector<char> scratch_;
+};
+
+class fec_decoder
+{
+  enum
+  {
+    max_groups = 4, // The recent groups can be recovered
+  };
+  struct group
+  {
+    uint32_t seq   = 0;
+    int count      = -1; // unknown until a parity shard received
+    uint64_t masks = 0;  // the received shards
+    std::vector<std::vector<char>> regions;
+  };
+
+public:
+  void reset(int data_shards, int parity_shards)
+  {
+    data_shards_   = data_shards;
+    parity_shards_ = parity_shards;
+    for (auto& g : groups_)
+    {
+      g.count = -1;
+      g.masks = 0;
+      g.regions.assign(data_shards + parity_shards, std::vector<char>());
+    }
+  }
+  bool enabled() const { return parity_shards_ > 0; }
+
+  // Decodes a shard, output the payload of data shard and the recovered data shards, returns
+  // false if it's not a fec shard.
+  template <typename _Fty> bool decode(const char* shard, int len, _Fty&& output)
+  {
+    if (len < fec_shard::overhead)
+      return false;
+    int type = fec_shard::type(shard);
+    if (type != fec_shard::data && type != fec_shard::parity)
+      return false;
+
+    auto group_size = static_cast<uint32_t>(data_shards_ + parity_shards_);
+    auto seq        = fec_shard::seq(shard);
+    auto index      = static_cast<int>(seq % group_size);
+    auto group_seq  = seq - index;
+    if ((type == fec_shard::data) != (index < data_shards_))
+      return true; // the peer has different fec settings
+
+    auto& g = groups_[(group_seq / group_size) % max_groups];
+    if (g.masks != 0 && static_cast<int32_t>(group_seq - g.seq) < 0)
+    { // too old to recover, the slot is used by a newer group
+      int size;
+      auto payload = fec_shard::payload(shard, len, size);
+      if (payload)
+        output(payload, size);
+      return true;
+    }
+    if (g.seq != group_seq || g.masks == 0)
+    { // the slot is reused by a new group
+      g.seq   = group_seq;
+      g.count = -1;
+      g.masks = 0;
+    }
+    if (g.masks & (1ULL << index)) // duplicated
+      return true;
+    g.masks |= (1ULL << index);
+    g.regions[index].assign(shard + fec_shard::header_size, shard + len);
+
+    int subset;
+    if (type == fec_shard::data)
+    {
+      int size;
+      auto payload = fec_shard::payload(shard, len, size);
+      if (payload)
+        output(payload, size);
+      subset = index % parity_shards_;
+    }
+    else
+    {
+      g.count = (std::min)(fec_shard::count(shard), data_shards_);
+      subset  = index - data_shards_;
+    }
+
+    recover(g, subset, output);
+    return true;
+  }
+
+private:
+  // Recovers the data shard covered by parity 'subset' if only it lost
+  template <typename _Fty> void recover(group& g, int subset, _Fty&& output)
+  {
+    int parity_index = data_shards_ + subset;
+    if (g.count < 0 || !(g.masks & (1ULL << parity_index)))
+      return;
+
+    int lost = -1;
+    for (int i = subset; i < g.count; i += parity_shards_)
+    {
+      if (!(g.masks & (1ULL << i)))
+      {
+        if (lost != -1)
+          return; // lost more than one
+        lost = i;
+      }
+    }
+    if (lost == -1)
+      return;
+
+    auto& region = g.regions[lost];
+    region       = g.regions[parity_index];
+    for (int i = subset; i < g.count; i += parity_shards_)
+    {
+      if (i == lost)
+        continue;
+      auto& other = g.regions[i];
+      for (size_t k = 0; k < other.size() && k < region.size(); ++k)
+        region[k] ^= other[k];
+    }
+    g.masks |= (1ULL << lost);
+
+    if (region.size() < sizeof(uint16_t))
+      return;
+    int size = fec_shard::size(&region.front());
+    if (size <= static_cast<int>(region.size() - sizeof(uint16_t)))
+      output(&region.front() + sizeof(uint16_t), size);
+  }
+
+  int data_shards_   = 0;
+  int parity_shards_ = 0;
+  group groups_[max_groups];
+};
+} // namespace yasio
+#endif
@@ -0,0 +1,116 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2020 HALX99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef YASIO__THREAD_POOL_HPP
+#define YASIO__THREAD_POOL_HPP
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yasio
+{
+/*
+** The fixed size thread pool, the threads are started on demand and live until join.
+*/
+class thread_pool
+{
+public:
+  typedef std::function<void()> task_type;
+
+  thread_pool(int threads = 1) : max_threads_(threads) {}
+  ~thread_pool() { join(); }
+
+  // Sets the max threads, the started threads are not affected
+  void set_max_threads(int threads)
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    max_threads_ = threads > 0 ? threads : 1;
+  }
+
+  // Queues a task, starts a new thread when all threads are busy
+  void run_task(task_type task)
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    tasks_.push_back(std::move(task));
+    if (idle_threads_ < static_cast<int>(tasks_.size()) &&
+        static_cast<int>(threads_.size()) < max_threads_)
+      threads_.push_back(std::thread(&thread_pool::run, this));
+    else
+      cv_.notify_one();
+  }
+
+  // Drops the queued tasks and waits the running tasks finish
+  void join()
+  {
+    std::unique_lock<std::mutex> lck(mtx_);
+    stopping_ = true;
+    tasks_.clear();
+    cv_.notify_all();
+    std::vector<std::thread> threads(std::move(threads_));
+    threads_.clear();
+    lck.unlock();
+
+    for (auto& t : threads)
+      t.join();
+
+    lck.lock();
+    stopping_ = false;
+  }
+
+private:
+  void run()
+  {
+    std::unique_lock<std::mutex> lck(mtx_);
+    for (;;)
+    {
+      ++idle_threads_;
+      cv_.wait(lck, [this] { return stopping_ || !tasks_.empty(); });
+      --idle_threads_;
+      if (stopping_)
+        break;
+
+      auto task = std::move(tasks_.front());
+      tasks_.pop_front();
+      lck.unlock();
+      task();
+      lck.lock();
+    }
+  }
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::deque<task_type> tasks_;
+  std::vector<std::thread> threads_;
+  int max_threads_;
+  int idle_threads_ = 0;
+  bool stopping_    = false;
+};
+} // namespace yasio
+#endif
@@ -28,6 +28,7 @@ SOFTWARE.
 #ifndef YASIO__IBSTREAM_CPP
 #define YASIO__IBSTREAM_CPP
 
+#include <algorithm>
 #include "yasio/obstream.hpp"
 #if !defined(YASIO_HEADER_ONLY)
 #  include "yasio/ibstream.hpp"
@@ -97,6 +98,104 @@ uint32_t ibstream_view::read_u24()
   return ntohl(value) >> 8;
 }
 
+int64_t ibstream_view::read_ix()
+{
+  uint64_t value = 0;
+  if (last_ - ptr_ >= 10)
+  { // the fast path, no bounds check per byte
+    auto p = reinterpret_cast<const uint8_t*>(ptr_);
+    for (int i = 0; i < 10; ++i)
+    {
+      value |= static_cast<uint64_t>(p[i] & 0x7F) << (7 * i);
+      if ((p[i] & 0x80) == 0)
+      {
+        ptr_ += i + 1;
+        return static_cast<int64_t>(value);
+      }
+    }
+    throw std::logic_error("Format_Bad7BitInt64");
+  }
+
+  int shift = 0;
+  uint8_t b;
+  do
+  {
+    if (shift == 10 * 7) // 10 bytes max per Int64
+      throw std::logic_error("Format_Bad7BitInt64");
+    b = read_i<uint8_t>();
+    value |= static_cast<uint64_t>(b & 0x7F) << shift;
+    shift += 7;
+  } while ((b & 0x80) != 0);
+  return static_cast<int64_t>(value);
+}
+
+int64_t ibstream_view::read_zx()
+{
+  return yasio::bits::zigzag_decode(static_cast<uint64_t>(read_ix()));
+}
+
+template <typename _Ty, typename _Fty>
+void ibstream_view::read_varint_array(_Ty* values, size_t count, const _Fty& transform)
+{
+  size_t i = 0;
+  auto ptr = reinterpret_cast<const uint8_t*>(ptr_);
+  auto end = reinterpret_cast<const uint8_t*>(last_);
+  while (i < count && end - ptr >= 16)
+  {
+    uint64_t word;
+    ::memcpy(&word, ptr, sizeof(word));
+    if ((word & 0x8080808080808080ULL) == 0 && count - i >= 8)
+    { // SWAR: 8 single byte values
+      for (int k = 0; k < 8; ++k)
+        values[i + k] = transform(ptr[k]);
+      i += 8;
+      ptr += 8;
+      continue;
+    }
+
+    // decode a varint without bounds check per byte
+    uint32_t b     = *ptr++;
+    uint32_t value = b & 0x7F;
+    if (b & 0x80)
+    {
+      b = *ptr++;
+      value |= (b & 0x7F) << 7;
+      if (b & 0x80)
+      {
+        b = *ptr++;
+        value |= (b & 0x7F) << 14;
+        if (b & 0x80)
+        {
+          b = *ptr++;
+          value |= (b & 0x7F) << 21;
+          if (b & 0x80)
+          {
+            b = *ptr++;
+            value |= b << 28;
+            if (b & 0x80)
+              throw std::logic_error("Format_Bad7BitInt32");
+          }
+        }
+      }
+    }
+    values[i++] = transform(value);
+  }
+  ptr_ = reinterpret_cast<const char*>(ptr);
+  for (; i < count; ++i) // the tail, read with bounds check per byte
+    values[i] = transform(static_cast<uint32_t>(read_i7()));
+}
+
+void ibstream_view::read_i7_array(uint32_t* values, size_t count)
+{
+  read_varint_array(values, count, [](uint32_t value) { return value; });
+}
+
+void ibstream_view::read_z7_array(int32_t* values, size_t count)
+{
+  read_varint_array(values, count,
+                    [](uint32_t value) { return yasio::bits::zigzag_decode32(value); });
+}
+
 cxx17::string_view ibstream_view::read_va()
 {
   int count = read_i7();
@@ -156,7 +255,7 @@ cxx17::string_view ibstream_view::read_bytes(int len)
 
 const char* ibstream_view::consume(size_t size)
 {
-  if (ptr_ >= last_)
+  if (size > static_cast<size_t>(last_ - ptr_))
     throw std::out_of_range("ibstream_view::consume out of range!");
 
   auto ptr = ptr_;
@@ -187,6 +286,189 @@ ptrdiff_t ibstream_view::seek(ptrdiff_t offset, int whence)
   return ptr_ - first_;
 }
 
+/// --------------------- CLASS checked_ibstream_view ---------------------
+int checked_ibstream_view::read_i7()
+{
+  uint32_t value = 0;
+  for (int shift = 0; shift < 5 * 7 && ptr_ < last_; shift += 7)
+  {
+    uint8_t b = *ptr_++;
+    value |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0)
+      return static_cast<int>(value);
+  }
+  fail(); // short read or more than 5 bytes
+  return 0;
+}
+
+int64_t checked_ibstream_view::read_ix()
+{
+  uint64_t value = 0;
+  for (int shift = 0; shift < 10 * 7 && ptr_ < last_; shift += 7)
+  {
+    uint8_t b = *ptr_++;
+    value |= static_cast<uint64_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0)
+      return static_cast<int64_t>(value);
+  }
+  fail();
+  return 0;
+}
+
+int32_t checked_ibstream_view::read_i24()
+{
+  uint32_t value = read_u24();
+  if (value >> 23)
+    return -(0x7FFFFF - (value & 0x7FFFFF)) - 1;
+  else
+    return value & 0x7FFFFF;
+}
+
+uint32_t checked_ibstream_view::read_u24()
+{
+  uint32_t value = 0;
+  if (!require(3))
+    return 0;
+  memcpy(&value, ptr_, 3);
+  ptr_ += 3;
+  return ntohl(value) >> 8;
+}
+
+/// --------------------- CLASS segmented_ibstream_view ---------------------
+void segmented_ibstream_view::reset(const cxx17::string_view* segments, int count)
+{
+  segments_ = segments;
+  count_    = count;
+  index_    = 0;
+  length_   = 0;
+  for (int i = 0; i < count; ++i)
+    length_ += segments[i].size();
+  remain_ = length_;
+  error_  = false;
+  ptr_    = last_ = nullptr;
+  if (count > 0)
+  {
+    ptr_  = segments[0].data();
+    last_ = ptr_ + segments[0].size();
+  }
+}
+
+int segmented_ibstream_view::read_i7()
+{
+  uint32_t value = 0;
+  for (int shift = 0; shift < 5 * 7 && remain_ > 0; shift += 7)
+  {
+    next_segment();
+    uint8_t b = *ptr_++;
+    --remain_;
+    value |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0)
+      return static_cast<int>(value);
+  }
+  fail(); // short read or more than 5 bytes
+  return 0;
+}
+
+int64_t segmented_ibstream_view::read_ix()
+{
+  uint64_t value = 0;
+  for (int shift = 0; shift < 10 * 7 && remain_ > 0; shift += 7)
+  {
+    next_segment();
+    uint8_t b = *ptr_++;
+    --remain_;
+    value |= static_cast<uint64_t>(b & 0x7F) << shift;
+    if ((b & 0x80) == 0)
+      return static_cast<int64_t>(value);
+  }
+  fail();
+  return 0;
+}
+
+int32_t segmented_ibstream_view::read_i24()
+{
+  uint32_t value = read_u24();
+  if (value >> 23)
+    return -(0x7FFFFF - (value & 0x7FFFFF)) - 1;
+  else
+    return value & 0x7FFFFF;
+}
+
+uint32_t segmented_ibstream_view::read_u24()
+{
+  uint32_t value = 0;
+  if (!read_bytes(&value, 3))
+    return 0;
+  return ntohl(value) >> 8;
+}
+
+bool segmented_ibstream_view::read_bytes(void* dst, size_t size)
+{
+  if (!require(size))
+    return false;
+  auto out = static_cast<char*>(dst);
+  remain_ -= size;
+  while (size > 0)
+  {
+    next_segment();
+    auto n = (std::min)(size, static_cast<size_t>(last_ - ptr_));
+    ::memcpy(out, ptr_, n);
+    out += n;
+    ptr_ += n;
+    size -= n;
+  }
+  return true;
+}
+
+cxx17::string_view segmented_ibstream_view::read_bytes(int len, std::string& scratch)
+{
+  if (len <= 0)
+  {
+    if (len < 0) // the length field overflow
+      fail();
+    return {};
+  }
+  if (!require(len))
+    return {};
+  next_segment();
+  if (static_cast<size_t>(last_ - ptr_) >= static_cast<size_t>(len))
+  { // in one slice, no copy
+    auto ptr = ptr_;
+    ptr_ += len;
+    remain_ -= len;
+    return cxx17::string_view(ptr, len);
+  }
+  scratch.resize(len);
+  read_bytes(&scratch.front(), len);
+  return cxx17::string_view(scratch.data(), len);
+}
+
+bool segmented_ibstream_view::skip(size_t size)
+{
+  if (!require(size))
+    return false;
+  remain_ -= size;
+  while (size > 0)
+  {
+    next_segment();
+    auto n = (std::min)(size, static_cast<size_t>(last_ - ptr_));
+    ptr_ += n;
+    size -= n;
+  }
+  return true;
+}
+
+void segmented_ibstream_view::fail()
+{
+  error_  = true;
+  remain_ = 0;
+  if (count_ > 0)
+  { // stays at the end of last slice, so the fast paths fail too
+    index_ = count_ - 1;
+    ptr_ = last_ = segments_[index_].data() + segments_[index_].size();
+  }
+}
+
 /// --------------------- CLASS ibstream ---------------------
 ibstream::ibstream(std::vector<char> blob) : ibstream_view(), blob_(std::move(blob))
 {
@@ -32,6 +32,7 @@ SOFTWARE.
 #include <sstream>
 #include <exception>
 #include <vector>
+#include <type_traits>
 #include "yasio/cxx17/string_view.hpp"
 #include "yasio/detail/endian_portable.hpp"
 #include "yasio/detail/config.hpp"
@@ -56,6 +57,13 @@ public:
 
   template <typename _Nty> inline _Nty read_i() { return sread_i<_Nty>(consume(sizeof(_Nty))); }
 
+  // Reads an array of numbers with one bounds check, the byte order is converted by span
+  template <typename _Nty> inline void read_array(_Nty* values, size_t count)
+  {
+    static_assert(std::is_arithmetic<_Nty>::value, "read_array only support number types");
+    yasio::endian::convert_array<sizeof(_Nty)>(values, consume(count * sizeof(_Nty)), count);
+  }
+
   template <typename _Nty> static _Nty sread_i(const void* src)
   {
     _Nty value;
@@ -65,6 +73,16 @@ public:
 
   YASIO__DECL int read_i7();
 
+  /* 64 bits LEB128 varint, will throw std::logic_error if more than 10 bytes */
+  YASIO__DECL int64_t read_ix();
+  /* zigzag signed varint */
+  YASIO__DECL int64_t read_zx();
+
+  /* The 32 bits varint arrays written by obstream::write_i7_array/write_z7_array, decodes 8
+   * bytes a time, will throw std::logic_error if a value more than 5 bytes */
+  YASIO__DECL void read_i7_array(uint32_t* values, size_t count);
+  YASIO__DECL void read_z7_array(int32_t* values, size_t count);
+
   YASIO__DECL int32_t read_i24();
   YASIO__DECL uint32_t read_u24();
 
@@ -110,6 +128,9 @@ protected:
   // will throw std::out_of_range
   YASIO__DECL const char* consume(size_t size);
 
+  template <typename _Ty, typename _Fty>
+  void read_varint_array(_Ty* values, size_t count, const _Fty& transform);
+
 protected:
   const char* first_;
   const char* last_;
@@ -141,6 +162,222 @@ private:
   std::vector<char> blob_;
 };
 
+/// --------------------- CLASS checked_ibstream_view ---------------------
+/*
+** The non-throwing ibstream_view for hot decode paths, a short read or malformed varint sets the
+** sticky error flag, then all following reads return zero values, so a whole message can be decoded
+** without try/catch and checked once at the end by ok().
+** The bounds check can be hoisted per field group by require & read_i_unchecked.
+*/
+class checked_ibstream_view
+{
+public:
+  checked_ibstream_view() { this->reset("", 0); }
+  checked_ibstream_view(const void* data, int size) { this->reset(data, size); }
+  checked_ibstream_view(const checked_ibstream_view&) = delete;
+  checked_ibstream_view& operator=(const checked_ibstream_view&) = delete;
+
+  void reset(const void* data, int size)
+  {
+    first_ = ptr_ = static_cast<const char*>(data);
+    last_         = first_ + size;
+    error_        = false;
+  }
+
+  bool ok() const { return !error_; }
+
+  // Ensures 'size' bytes remain, otherwise sets the error flag and returns false
+  bool require(size_t size)
+  {
+    if (size > static_cast<size_t>(last_ - ptr_))
+      fail();
+    return !error_;
+  }
+
+  template <typename _Nty> inline _Nty read_i()
+  {
+    return require(sizeof(_Nty)) ? read_i_unchecked<_Nty>() : _Nty{};
+  }
+
+  // Reads without bounds check, only call it after require the bytes of a field group
+  template <typename _Nty> inline _Nty read_i_unchecked()
+  {
+    auto ptr = ptr_;
+    ptr_ += sizeof(_Nty);
+    return ibstream_view::sread_i<_Nty>(ptr);
+  }
+
+  template <typename _Nty> inline bool read_array(_Nty* values, size_t count)
+  {
+    if (!require(count * sizeof(_Nty)))
+      return false;
+    read_array_unchecked(values, count);
+    return true;
+  }
+
+  // Reads without bounds check, the byte order of any number type is converted by span
+  template <typename _Nty> inline void read_array_unchecked(_Nty* values, size_t count)
+  {
+    static_assert(std::is_arithmetic<_Nty>::value, "read_array only support number types");
+    yasio::endian::convert_array<sizeof(_Nty)>(values, ptr_, count);
+    ptr_ += count * sizeof(_Nty);
+  }
+
+  YASIO__DECL int read_i7();
+  YASIO__DECL int64_t read_ix();
+  int64_t read_zx() { return yasio::bits::zigzag_decode(static_cast<uint64_t>(read_ix())); }
+
+  YASIO__DECL int32_t read_i24();
+  YASIO__DECL uint32_t read_u24();
+
+  cxx17::string_view read_bytes(int len)
+  {
+    if (len <= 0)
+    {
+      if (len < 0) // the length field overflow
+        fail();
+      return {};
+    }
+    if (!require(len))
+      return {};
+    auto ptr = ptr_;
+    ptr_ += len;
+    return cxx17::string_view(ptr, len);
+  }
+
+  cxx17::string_view read_v() { return read_bytes(static_cast<int>(read_i<uint32_t>())); }
+  cxx17::string_view read_v16() { return read_bytes(read_i<uint16_t>()); }
+  cxx17::string_view read_v8() { return read_bytes(read_i<uint8_t>()); }
+  cxx17::string_view read_va() { return read_bytes(read_i7()); }
+
+  const char* data() const { return first_; }
+  size_t length() const { return last_ - first_; }
+  size_t remain() const { return last_ - ptr_; }
+
+protected:
+  void fail()
+  {
+    error_ = true;
+    ptr_   = last_;
+  }
+
+  const char* first_;
+  const char* last_;
+  const char* ptr_;
+  bool error_;
+};
+
+/// --------------------- CLASS segmented_ibstream_view ---------------------
+/*
+** The non-throwing reader over a list of buffer slices, for example the chunks of a partially
+** received frame, the fields straddle the slices boundaries are assembled transparently, so the
+** decoding needn't concatenate the slices first. The error model is same as checked_ibstream_view,
+** when require fails on partial data, the caller can reset with more slices and decode again.
+** remark: the slices must be alive and unchanged while reading.
+*/
+class segmented_ibstream_view
+{
+public:
+  segmented_ibstream_view() { this->reset(nullptr, 0); }
+  segmented_ibstream_view(const cxx17::string_view* segments, int count)
+  {
+    this->reset(segments, count);
+  }
+  segmented_ibstream_view(const segmented_ibstream_view&) = delete;
+  segmented_ibstream_view& operator=(const segmented_ibstream_view&) = delete;
+
+  YASIO__DECL void reset(const cxx17::string_view* segments, int count);
+
+  bool ok() const { return !error_; }
+
+  // Ensures 'size' bytes remain in all slices, otherwise sets the error flag and returns false
+  bool require(size_t size)
+  {
+    if (size > remain_)
+      fail();
+    return !error_;
+  }
+
+  template <typename _Nty> inline _Nty read_i()
+  {
+    if (sizeof(_Nty) <= static_cast<size_t>(last_ - ptr_))
+    { // the fast path, the field is in current slice
+      auto ptr = ptr_;
+      ptr_ += sizeof(_Nty);
+      remain_ -= sizeof(_Nty);
+      return ibstream_view::sread_i<_Nty>(ptr);
+    }
+    char buf[sizeof(_Nty)];
+    return read_bytes(buf, sizeof(buf)) ? ibstream_view::sread_i<_Nty>(buf) : _Nty{};
+  }
+
+  template <typename _Nty> inline bool read_array(_Nty* values, size_t count)
+  {
+    static_assert(std::is_arithmetic<_Nty>::value, "read_array only support number types");
+    if (!read_bytes(values, count * sizeof(_Nty)))
+      return false;
+    yasio::endian::convert_array<sizeof(_Nty)>(values, values, count);
+    return true;
+  }
+
+  YASIO__DECL int read_i7();
+  YASIO__DECL int64_t read_ix();
+  int64_t read_zx() { return yasio::bits::zigzag_decode(static_cast<uint64_t>(read_ix())); }
+
+  YASIO__DECL int32_t read_i24();
+  YASIO__DECL uint32_t read_u24();
+
+  // Copies 'size' bytes to 'dst' across the slices
+  YASIO__DECL bool read_bytes(void* dst, size_t size);
+
+  /* Refers to the slice if the bytes in one slice, otherwise assembled to 'scratch', so the view
+   * is valid until 'scratch' changed. */
+  YASIO__DECL cxx17::string_view read_bytes(int len, std::string& scratch);
+
+  cxx17::string_view read_v(std::string& scratch)
+  {
+    return read_bytes(static_cast<int>(read_i<uint32_t>()), scratch);
+  }
+  cxx17::string_view read_v16(std::string& scratch)
+  {
+    return read_bytes(read_i<uint16_t>(), scratch);
+  }
+  cxx17::string_view read_v8(std::string& scratch)
+  {
+    return read_bytes(read_i<uint8_t>(), scratch);
+  }
+  cxx17::string_view read_va(std::string& scratch) { return read_bytes(read_i7(), scratch); }
+
+  YASIO__DECL bool skip(size_t size);
+
+  size_t length() const { return length_; }
+  size_t remain() const { return remain_; }
+  // The bytes consumed, the caller can release the slices before it
+  size_t offset() const { return length_ - remain_; }
+
+protected:
+  // Moves to the next non-empty slice when current slice exhausted
+  void next_segment()
+  {
+    while (ptr_ == last_ && index_ + 1 < count_)
+    {
+      ++index_;
+      ptr_  = segments_[index_].data();
+      last_ = ptr_ + segments_[index_].size();
+    }
+  }
+
+  YASIO__DECL void fail();
+
+  const cxx17::string_view* segments_;
+  int count_;
+  int index_;
+  const char* ptr_;
+  const char* last_;
+  size_t length_;
+  size_t remain_;
+  bool error_;
+};
 } // namespace yasio
 
 #if defined(YASIO_HEADER_ONLY)
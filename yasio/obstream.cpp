@@ -32,6 +32,8 @@ SOFTWARE.
 #endif
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <stdexcept>
 
 namespace yasio
 {
@@ -40,80 +42,103 @@ obstream::obstream(size_t capacity) { buffer_.reserve(capacity); }
 
 void obstream::push8()
 {
-  offset_stack_.push(buffer_.size());
+  push_offset();
   write_i(static_cast<uint8_t>(0));
 }
 void obstream::pop8()
 {
-  auto offset = offset_stack_.top();
+  auto offset = pop_offset();
   pwrite_i(offset, static_cast<uint8_t>(buffer_.size() - offset - sizeof(uint8_t)));
-  offset_stack_.pop();
 }
 void obstream::pop8(uint8_t value)
 {
-  auto offset = offset_stack_.top();
+  auto offset = pop_offset();
   pwrite_i(offset, value);
-  offset_stack_.pop();
 }
 
 void obstream::push16()
 {
-  offset_stack_.push(buffer_.size());
+  push_offset();
   write_i(static_cast<uint16_t>(0));
 }
 void obstream::pop16()
 {
-  auto offset = offset_stack_.top();
+  auto offset = pop_offset();
   pwrite_i(offset, static_cast<uint16_t>(buffer_.size() - offset - sizeof(uint16_t)));
-  offset_stack_.pop();
 }
 void obstream::pop16(uint16_t value)
 {
-  auto offset = offset_stack_.top();
+  auto offset = pop_offset();
   pwrite_i(offset, value);
-  offset_stack_.pop();
 }
 
 void obstream::push24()
 {
-  offset_stack_.push(buffer_.size());
+  push_offset();
 
   unsigned char u32buf[4] = {0, 0, 0, 0};
   write_bytes(u32buf, 3);
 }
 void obstream::pop24()
 {
-  auto offset = offset_stack_.top();
+  auto offset = pop_offset();
   auto value  = htonl(static_cast<uint32_t>(buffer_.size() - offset - 3)) >> 8;
   memcpy(wptr(offset), &value, 3);
-  offset_stack_.pop();
 }
 void obstream::pop24(uint32_t value)
 {
-  auto offset = offset_stack_.top();
+  auto offset = pop_offset();
   value       = htonl(value) >> 8;
   memcpy(wptr(offset), &value, 3);
-  offset_stack_.pop();
 }
 
 void obstream::push32()
 {
-  offset_stack_.push(buffer_.size());
+  push_offset();
   write_i(static_cast<uint32_t>(0));
 }
 
 void obstream::pop32()
 {
-  auto offset = offset_stack_.top();
+  auto offset = pop_offset();
   pwrite_i(offset, static_cast<uint32_t>(buffer_.size() - offset - sizeof(uint32_t)));
-  offset_stack_.pop();
 }
 
 void obstream::pop32(uint32_t value)
 {
-  auto offset = offset_stack_.top();
+  auto offset = pop_offset();
   pwrite_i(offset, value);
-  offset_stack_.pop();
+}
+
+void obstream::push_va()
+{
+  push_offset();
+  buffer_.resize(buffer_.size() + 4); // 28 bits varint at most
+}
+
+void obstream::pop_va()
+{
+  auto offset = pop_offset();
+  auto length = buffer_.size() - offset - 4;
+  if (length >= (1U << 28))
+    throw std::length_error("obstream::pop_va length exceeds 28 bits!");
+  auto size = static_cast<uint32_t>(length);
+  if (size < (1U << 14))
+  { // compact to the shortest varint, moves 16KB at most
+    char buf[10];
+    int n = yasio::bits::varint_encode(size, buf);
+    ::memmove(wptr(offset + n), wptr(offset + 4), size);
+    buffer_.resize(offset + n + size);
+    ::memcpy(wptr(offset), buf, n);
+  }
+  else
+  { // the redundant 4 bytes varint, the leading bytes have continuation bit
+    auto ptr = wptr(offset);
+    ptr[0]   = static_cast<char>((size & 0x7f) | 0x80);
+    ptr[1]   = static_cast<char>(((size >> 7) & 0x7f) | 0x80);
+    ptr[2]   = static_cast<char>(((size >> 14) & 0x7f) | 0x80);
+    ptr[3]   = static_cast<char>(size >> 21);
+  }
 }
 
 obstream::obstream(const obstream& right) : buffer_(right.buffer_) {}
@@ -146,13 +171,40 @@ void obstream::write_i7(int value)
 {
   // Write out an int 7 bits at a time.  The high bit of the byte,
   // when on, tells reader to continue reading more bytes.
-  uint32_t v = (uint32_t)value; // support negative numbers
-  while (v >= 0x80)
-  {
-    write_i<uint8_t>((uint8_t)(v | 0x80));
-    v >>= 7;
-  }
-  write_i<uint8_t>((uint8_t)v);
+  char buf[10];
+  write_bytes(buf, yasio::bits::varint_encode((uint32_t)value, buf)); // support negative numbers
+}
+
+void obstream::write_ix(int64_t value)
+{
+  char buf[10];
+  write_bytes(buf, yasio::bits::varint_encode(static_cast<uint64_t>(value), buf));
+}
+
+void obstream::write_zx(int64_t value)
+{
+  char buf[10];
+  write_bytes(buf, yasio::bits::varint_encode(yasio::bits::zigzag_encode(value), buf));
+}
+
+void obstream::write_i7_array(const uint32_t* values, size_t count)
+{
+  auto offset = buffer_.size();
+  buffer_.resize(offset + count * 5 + 5); // 5 bytes max per uint32, and the spare for encoding
+  auto ptr = &buffer_[offset];
+  for (size_t i = 0; i < count; ++i)
+    ptr += yasio::bits::varint_encode(values[i], ptr);
+  buffer_.resize(ptr - buffer_.data());
+}
+
+void obstream::write_z7_array(const int32_t* values, size_t count)
+{
+  auto offset = buffer_.size();
+  buffer_.resize(offset + count * 5 + 5);
+  auto ptr = &buffer_[offset];
+  for (size_t i = 0; i < count; ++i)
+    ptr += yasio::bits::varint_encode(yasio::bits::zigzag_encode32(values[i]), ptr);
+  buffer_.resize(ptr - buffer_.data());
 }
 
 void obstream::write_va(cxx17::string_view sv)
@@ -205,6 +257,186 @@ void obstream::save(const char* filename)
   fout.close();
 }
 
+namespace
+{
+struct obstream_shared_pool
+{
+  std::mutex mtx;
+  std::vector<std::vector<char>> buffers;
+};
+static obstream_shared_pool& yasio__obstream_shared_pool()
+{ // never destroyed, the static io_service may release the pdus after the statics of this file
+  static obstream_shared_pool* pool = new obstream_shared_pool();
+  return *pool;
+}
+
+static thread_local bool yasio__obstream_local_pool_destroyed = false;
+struct obstream_local_pool
+{
+  ~obstream_local_pool() { yasio__obstream_local_pool_destroyed = true; }
+  std::vector<std::vector<char>> buffers;
+};
+// Returns nullptr when the thread is exiting and the thread cache destroyed
+static std::vector<std::vector<char>>* yasio__obstream_local_pool()
+{
+  if (yasio__obstream_local_pool_destroyed)
+    return nullptr;
+  static thread_local obstream_local_pool pool;
+  return &pool.buffers;
+}
+} // namespace
+
+std::vector<char> obstream_pool::acquire(size_t capacity)
+{
+  std::vector<char> buffer;
+  auto local = yasio__obstream_local_pool();
+  if (local)
+  {
+    if (local->empty())
+    { // refill half of the thread cache from shared pool
+      auto& shared = yasio__obstream_shared_pool();
+      std::lock_guard<std::mutex> lck(shared.mtx);
+      for (int i = 0; i < max_local_count / 2 && !shared.buffers.empty(); ++i)
+      {
+        local->push_back(std::move(shared.buffers.back()));
+        shared.buffers.pop_back();
+      }
+    }
+
+    if (!local->empty())
+    {
+      buffer = std::move(local->back());
+      local->pop_back();
+    }
+  }
+  buffer.reserve(capacity);
+  return buffer;
+}
+
+void obstream_pool::recycle(std::vector<char>&& buffer)
+{
+  if (buffer.capacity() == 0 || buffer.capacity() > max_capacity)
+    return;
+
+  auto local = yasio__obstream_local_pool();
+  if (!local) // the buffer is simply freed by caller
+    return;
+  buffer.clear();
+  if (local->size() >= max_local_count)
+  { // spill half of the thread cache to shared pool
+    auto& shared = yasio__obstream_shared_pool();
+    std::lock_guard<std::mutex> lck(shared.mtx);
+    while (local->size() > max_local_count / 2)
+    {
+      if (shared.buffers.size() < max_count)
+        shared.buffers.push_back(std::move(local->back()));
+      local->pop_back();
+    }
+  }
+  local->push_back(std::move(buffer));
+}
+
+void chain_obstream::push8()
+{
+  obstream::push8();
+  ref_marks_.push(ref_size_);
+}
+void chain_obstream::pop8()
+{
+  auto offset = offset_stack_.top();
+  obstream::pop8(
+      static_cast<uint8_t>(buffer_.size() - offset - sizeof(uint8_t) + pop_ref_size()));
+}
+void chain_obstream::pop8(uint8_t value)
+{
+  ref_marks_.pop();
+  obstream::pop8(value);
+}
+
+void chain_obstream::push16()
+{
+  obstream::push16();
+  ref_marks_.push(ref_size_);
+}
+void chain_obstream::pop16()
+{
+  auto offset = offset_stack_.top();
+  obstream::pop16(
+      static_cast<uint16_t>(buffer_.size() - offset - sizeof(uint16_t) + pop_ref_size()));
+}
+void chain_obstream::pop16(uint16_t value)
+{
+  ref_marks_.pop();
+  obstream::pop16(value);
+}
+
+void chain_obstream::push24()
+{
+  obstream::push24();
+  ref_marks_.push(ref_size_);
+}
+void chain_obstream::pop24()
+{
+  auto offset = offset_stack_.top();
+  obstream::pop24(static_cast<uint32_t>(buffer_.size() - offset - 3 + pop_ref_size()));
+}
+void chain_obstream::pop24(uint32_t value)
+{
+  ref_marks_.pop();
+  obstream::pop24(value);
+}
+
+void chain_obstream::push32()
+{
+  obstream::push32();
+  ref_marks_.push(ref_size_);
+}
+void chain_obstream::pop32()
+{
+  auto offset = offset_stack_.top();
+  obstream::pop32(
+      static_cast<uint32_t>(buffer_.size() - offset - sizeof(uint32_t) + pop_ref_size()));
+}
+void chain_obstream::pop32(uint32_t value)
+{
+  ref_marks_.pop();
+  obstream::pop32(value);
+}
+
+void chain_obstream::write_ref(const void* data, int size, std::shared_ptr<const void> owner)
+{
+  if (size < YASIO_MIN_REF_SIZE)
+  {
+    write_bytes(data, size);
+    return;
+  }
+  refs_.push_back(blob_ref{buffer_.size(), static_cast<const char*>(data), (size_t)size});
+  if (owner)
+    owners_.push_back(std::move(owner));
+  ref_size_ += size;
+}
+
+void chain_obstream::write_v_ref(const void* data, int size, std::shared_ptr<const void> owner)
+{
+  write_i(static_cast<uint32_t>(size));
+  write_ref(data, size, std::move(owner));
+}
+
+std::vector<char> chain_obstream::flatten() const
+{
+  std::vector<char> buffer;
+  buffer.reserve(length());
+  size_t offset = 0;
+  for (auto& ref : refs_)
+  {
+    buffer.insert(buffer.end(), buffer_.data() + offset, buffer_.data() + ref.offset);
+    buffer.insert(buffer.end(), ref.data, ref.data + ref.size);
+    offset = ref.offset;
+  }
+  buffer.insert(buffer.end(), buffer_.data() + offset, buffer_.data() + buffer_.size());
+  return buffer;
+}
+
 obstream obstream::sub(size_t offset, size_t count)
 {
   obstream obs;
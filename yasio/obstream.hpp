@@ -28,18 +28,61 @@ SOFTWARE.
 #ifndef YASIO__OBSTREAM_HPP
 #define YASIO__OBSTREAM_HPP
 #include <stddef.h>
+#include <assert.h>
 #include <string>
 #include "yasio/cxx17/string_view.hpp"
 #include <sstream>
 #include <vector>
-#include <stack>
+#include <memory>
+#include <type_traits>
 #include "yasio/detail/endian_portable.hpp"
 #include "yasio/detail/config.hpp"
 namespace yasio
 {
+namespace detail
+{
+// The stack of length placeholders, the first _InlineSize levels never allocate, the deeper ones
+// spill to heap
+template <typename _Ty, int _InlineSize> class placeholder_stack
+{
+public:
+  void push(_Ty value)
+  {
+    if (depth_ < _InlineSize)
+      inline_[depth_] = value;
+    else
+      spill_.push_back(value);
+    ++depth_;
+  }
+  _Ty pop()
+  {
+    auto value = top();
+    if (--depth_ >= _InlineSize)
+      spill_.pop_back();
+    return value;
+  }
+  _Ty top() const
+  {
+    assert(depth_ > 0);
+    return depth_ <= _InlineSize ? inline_[depth_ - 1] : spill_.back();
+  }
+  int depth() const { return depth_; }
+
+private:
+  _Ty inline_[_InlineSize];
+  std::vector<_Ty> spill_;
+  int depth_ = 0;
+};
+} // namespace detail
+
 class obstream
 {
 public:
+  enum
+  {
+    max_nested_depth = 16, // The nested depth of push/pop length placeholders without allocation
+  };
+
   YASIO__DECL obstream(size_t capacity = 128);
   YASIO__DECL obstream(const obstream& rhs);
   YASIO__DECL obstream(obstream&& rhs);
@@ -61,16 +104,34 @@ public:
   YASIO__DECL void pop32();
   YASIO__DECL void pop32(uint32_t);
 
+  /* varint length placeholder, read by read_va, will throw std::length_error at pop if the length
+   * is not less than 256MB */
+  YASIO__DECL void push_va();
+  YASIO__DECL void pop_va();
+
   YASIO__DECL obstream& operator=(const obstream& rhs);
   YASIO__DECL obstream& operator=(obstream&& rhs);
 
   template <typename _Nty> inline void write_i(_Nty value);
 
+  // Writes an array of numbers, the byte order is converted by span
+  template <typename _Nty> inline void write_array(const _Nty* values, size_t count);
+
   YASIO__DECL void write_i24(int32_t value);  // highest bit as sign
   YASIO__DECL void write_u24(uint32_t value); // highest byte ignored
 
   YASIO__DECL void write_i7(int value);
 
+  /* 64 bits LEB128 varint, at most 10 bytes */
+  YASIO__DECL void write_ix(int64_t value);
+  /* zigzag signed varint, the small negative numbers are encoded as short as positive */
+  YASIO__DECL void write_zx(int64_t value);
+
+  /* 32 bits varint arrays like write_i7, the buffer grows once per array, read by
+   * ibstream_view::read_i7_array/read_z7_array */
+  YASIO__DECL void write_i7_array(const uint32_t* values, size_t count);
+  YASIO__DECL void write_z7_array(const int32_t* values, size_t count);
+
   /* write blob data with variant length of length field. */
   YASIO__DECL void write_va(cxx17::string_view sv);
 
@@ -124,10 +185,118 @@ public:
   YASIO__DECL void save(const char* filename);
 
 protected:
+  void push_offset() { offset_stack_.push(buffer_.size()); }
+  size_t pop_offset() { return offset_stack_.pop(); }
+
   std::vector<char> buffer_;
-  std::stack<size_t> offset_stack_;
+  detail::placeholder_stack<size_t, max_nested_depth> offset_stack_;
 }; // CLASS obstream
 
+/*
+** The buffer pool of pooled_obstream, the buffers are cached by thread, and spill to/refill from
+** a shared pool, so the buffers released by io_service thread can be reused by the encoding
+** threads.
+*/
+class obstream_pool
+{
+public:
+  enum
+  {
+    max_capacity    = 64 * 1024, // The larger buffers are not cached
+    max_local_count = 16,        // The max buffers of thread cache
+    max_count       = 256,       // The max buffers of shared pool
+  };
+
+  // Acquires an empty buffer which capacity at least 'capacity'
+  YASIO__DECL static std::vector<char> acquire(size_t capacity);
+
+  // Returns a buffer to the pool, it's dropped if too large or the pool is full
+  YASIO__DECL static void recycle(std::vector<char>&& buffer);
+};
+
+// The obstream which writes to a pooled buffer, and returns it to the pool when destructing,
+// the steady state message encoding doesn't allocate memory.
+// remark: the buffer handed to io_service::write is recycled after sent.
+class pooled_obstream : public obstream
+{
+public:
+  pooled_obstream(size_t capacity = 128) : obstream(0)
+  {
+    buffer_ = obstream_pool::acquire(capacity);
+  }
+  pooled_obstream(const pooled_obstream& rhs) = delete;
+  pooled_obstream& operator=(const pooled_obstream& rhs) = delete;
+  ~pooled_obstream() { obstream_pool::recycle(std::move(buffer_)); }
+};
+
+/*
+** The scatter-gather obstream, the small fields are written to the inline buffer, and the large
+** blobs are referenced by pointer with a lifetime owner, io_service::write sends the segments
+** with sendmsg/WSASend without flattening.
+** remark:
+**   + the length placeholders cover the referenced blobs too.
+**   + push8~pop32 hide the obstream ones, they're not virtual, so never write the placeholders
+**     through obstream& or obstream*, otherwise the lengths exclude the referenced blobs, and
+**     the placeholder stacks go unbalanced.
+*/
+class chain_obstream : public obstream
+{
+public:
+  struct blob_ref
+  {
+    size_t offset; // The inline buffer offset which the blob inserted at
+    const char* data;
+    size_t size;
+  };
+
+  chain_obstream(size_t capacity = 128) : obstream(capacity) {}
+
+  // The placeholders hide the obstream ones, must be called on chain_obstream directly
+  YASIO__DECL void push8();
+  YASIO__DECL void pop8();
+  YASIO__DECL void pop8(uint8_t);
+  YASIO__DECL void push16();
+  YASIO__DECL void pop16();
+  YASIO__DECL void pop16(uint16_t);
+  YASIO__DECL void push24();
+  YASIO__DECL void pop24();
+  YASIO__DECL void pop24(uint32_t);
+  YASIO__DECL void push32();
+  YASIO__DECL void pop32();
+  YASIO__DECL void pop32(uint32_t);
+
+  // The varint placeholder is compacted at pop, which would shift the refs after it
+  void push_va() = delete;
+  void pop_va()  = delete;
+
+  /* Writes a blob by reference, the 'owner' keeps the blob alive until it sent, the blob smaller
+   * than YASIO_MIN_REF_SIZE is copied. */
+  YASIO__DECL void write_ref(const void* data, int size, std::shared_ptr<const void> owner);
+
+  /* 32 bits length field & the blob by reference */
+  YASIO__DECL void write_v_ref(const void* data, int size, std::shared_ptr<const void> owner);
+
+  // The total bytes of inline buffer and referenced blobs
+  size_t length() const { return buffer_.size() + ref_size_; }
+
+  const std::vector<blob_ref>& refs() const { return refs_; }
+  std::vector<blob_ref>& refs() { return refs_; }
+  std::vector<std::shared_ptr<const void>>& owners() { return owners_; }
+
+  // Copies the segments to a contiguous buffer, for the transports not support scatter-gather
+  YASIO__DECL std::vector<char> flatten() const;
+
+protected:
+  // The referenced bytes since the innermost placeholder pushed, pops its mark
+  size_t pop_ref_size() { return ref_size_ - ref_marks_.pop(); }
+
+  std::vector<blob_ref> refs_;
+  std::vector<std::shared_ptr<const void>> owners_;
+  size_t ref_size_ = 0;
+  // The ref_size_ when the placeholders pushed
+  detail::placeholder_stack<size_t, max_nested_depth> ref_marks_;
+};
+
 template <typename _Nty> inline void obstream::write_i(_Nty value)
 {
   auto nv = yasio::endian::htonv(value);
@@ -135,6 +304,17 @@ template <typename _Nty> inline void obstream::write_i(_Nty value)
   write_bytes(&nv, sizeof(nv));
 }
 
+template <typename _Nty> inline void obstream::write_array(const _Nty* values, size_t count)
+{
+  static_assert(std::is_arithmetic<_Nty>::value, "write_array only support number types");
+  if (count > 0)
+  {
+    auto offset = buffer_.size();
+    buffer_.resize(offset + count * sizeof(_Nty));
+    yasio::endian::convert_array<sizeof(_Nty)>(&buffer_[offset], values, count);
+  }
+}
+
 template <> inline void obstream::write_i<float>(float value)
 {
   auto nv = htonf(value);
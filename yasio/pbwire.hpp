@@ -0,0 +1,266 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2020 HALX99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef YASIO__PBWIRE_HPP
+#define YASIO__PBWIRE_HPP
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include "yasio/obstream.hpp"
+#include "yasio/ibstream.hpp"
+
+/*
+** The protobuf wire format writer & reader, encodes to obstream and decodes from the packet
+** without any intermediate message objects:
+**   yasio::pb::writer pbw(obs);
+**   pbw.write_uint32(1, id);
+**   pbw.begin_message(2); // nested message, the length is backpatched by end_message
+**   pbw.write_float(1, x);
+**   pbw.end_message();
+**
+**   yasio::pb::reader pbr(data, size);
+**   while (pbr.next())
+**     switch (pbr.field()) {
+**       case 1: id = pbr.read_uint32(); break;
+**       case 2: pos = pbr.read_string(); break; // decode it by another reader
+**       default: pbr.skip();
+**     }
+**   if (!pbr.ok()) ... // malformed or truncated
+** remark: the nested message shorter than 16KB has the shortest length varint, the longer one
+** has 4 bytes length varint, both are valid for any protobuf parser.
+*/
+namespace yasio
+{
+namespace pb
+{
+enum wire_type
+{
+  varint           = 0,
+  fixed64          = 1,
+  length_delimited = 2,
+  fixed32          = 5,
+};
+
+class writer
+{
+public:
+  explicit writer(obstream& obs) : obs_(obs) {}
+  // The nested message length placeholder of chain_obstream is not supported, see push_va
+  writer(chain_obstream&) = delete;
+
+  void write_tag(uint32_t field, wire_type type) { write_varint((field << 3) | type); }
+  void write_varint(uint64_t value) { obs_.write_ix(static_cast<int64_t>(value)); }
+
+  // The negative int32 is sign extended to 10 bytes as protobuf does
+  void write_int32(uint32_t field, int32_t value) { write_uint64(field, value); }
+  void write_int64(uint32_t field, int64_t value) { write_uint64(field, value); }
+  void write_uint32(uint32_t field, uint32_t value) { write_uint64(field, value); }
+  void write_uint64(uint32_t field, uint64_t value)
+  {
+    char buf[20]; // the tag & value are written at once
+    int n = yasio::bits::varint_encode((field << 3) | varint, buf);
+    n += yasio::bits::varint_encode(value, buf + n);
+    obs_.write_bytes(buf, n);
+  }
+  void write_sint32(uint32_t field, int32_t value) { write_sint64(field, value); }
+  void write_sint64(uint32_t field, int64_t value)
+  {
+    write_uint64(field, yasio::bits::zigzag_encode(value));
+  }
+  void write_bool(uint32_t field, bool value) { write_uint64(field, value ? 1 : 0); }
+
+  void write_fixed32(uint32_t field, uint32_t value) { write_fixed(field, fixed32, value, 4); }
+  void write_fixed64(uint32_t field, uint64_t value) { write_fixed(field, fixed64, value, 8); }
+  void write_sfixed32(uint32_t field, int32_t value)
+  {
+    write_fixed32(field, static_cast<uint32_t>(value));
+  }
+  void write_sfixed64(uint32_t field, int64_t value)
+  {
+    write_fixed64(field, static_cast<uint64_t>(value));
+  }
+  void write_float(uint32_t field, float value)
+  {
+    uint32_t bits;
+    ::memcpy(&bits, &value, sizeof(bits));
+    write_fixed32(field, bits);
+  }
+  void write_double(uint32_t field, double value)
+  {
+    uint64_t bits;
+    ::memcpy(&bits, &value, sizeof(bits));
+    write_fixed64(field, bits);
+  }
+
+  // The string or bytes field
+  void write_string(uint32_t field, cxx17::string_view value)
+  {
+    write_tag(field, length_delimited);
+    obs_.write_va(value);
+  }
+
+  // The packed repeated uint32 field, the buffer grows once
+  void write_packed_uint32(uint32_t field, const uint32_t* values, size_t count)
+  {
+    if (count == 0)
+      return;
+    begin_message(field);
+    obs_.write_i7_array(values, count);
+    end_message();
+  }
+
+  // The nested message, the fields are written between begin_message & end_message
+  void begin_message(uint32_t field)
+  {
+    write_tag(field, length_delimited);
+    obs_.push_va();
+  }
+  void end_message() { obs_.pop_va(); }
+
+  obstream& stream() { return obs_; }
+
+private:
+  // The little endian fixed size value
+  void write_fixed(uint32_t field, wire_type type, uint64_t value, int size)
+  {
+    char buf[13];
+    int n = yasio::bits::varint_encode((field << 3) | type, buf);
+    for (int i = 0; i < size; ++i)
+      buf[n++] = static_cast<char>(value >> (i * 8));
+    obs_.write_bytes(buf, n);
+  }
+
+  obstream& obs_;
+};
+
+/*
+** The reader never throws, the malformed or truncated input sets the error flag, then next()
+** returns false and the reads return zero.
+*/
+class reader : public checked_ibstream_view
+{
+public:
+  reader() {}
+  reader(const void* data, int size) : checked_ibstream_view(data, size) {}
+  explicit reader(cxx17::string_view message)
+      : checked_ibstream_view(message.data(), static_cast<int>(message.size()))
+  {}
+
+  // Reads the next tag, returns false at the end of message or on error
+  bool next()
+  {
+    if (ptr_ == last_)
+      return false;
+    auto tag = static_cast<uint64_t>(read_ix());
+    field_   = static_cast<uint32_t>(tag >> 3);
+    type_    = static_cast<int>(tag & 7);
+    if (field_ == 0 || tag > UINT32_MAX)
+      fail();
+    return ok();
+  }
+
+  uint32_t field() const { return field_; }
+  int type() const { return type_; }
+
+  uint64_t read_varint() { return static_cast<uint64_t>(read_ix()); }
+
+  int32_t read_int32() { return static_cast<int32_t>(read_ix()); }
+  int64_t read_int64() { return read_ix(); }
+  uint32_t read_uint32() { return static_cast<uint32_t>(read_ix()); }
+  uint64_t read_uint64() { return read_varint(); }
+  int32_t read_sint32() { return static_cast<int32_t>(read_zx()); }
+  int64_t read_sint64() { return read_zx(); }
+  bool read_bool() { return read_ix() != 0; }
+
+  uint32_t read_fixed32()
+  {
+    if (!require(4))
+      return 0;
+    auto ptr = reinterpret_cast<const uint8_t*>(ptr_);
+    ptr_ += 4;
+    return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | (static_cast<uint32_t>(ptr[3]) << 24);
+  }
+  uint64_t read_fixed64()
+  {
+    uint64_t lo = read_fixed32();
+    return lo | (static_cast<uint64_t>(read_fixed32()) << 32);
+  }
+  int32_t read_sfixed32() { return static_cast<int32_t>(read_fixed32()); }
+  int64_t read_sfixed64() { return static_cast<int64_t>(read_fixed64()); }
+  float read_float()
+  {
+    auto bits = read_fixed32();
+    float value;
+    ::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  double read_double()
+  {
+    auto bits = read_fixed64();
+    double value;
+    ::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  // The string, bytes, nested message or packed repeated field, refers to the packet
+  cxx17::string_view read_string()
+  {
+    auto size = read_varint();
+    return read_bytes(size <= INT_MAX ? static_cast<int>(size) : -1);
+  }
+
+  // Skips the value of current field, the deprecated groups are not supported
+  void skip()
+  {
+    switch (type_)
+    {
+      case varint:
+        read_ix();
+        break;
+      case fixed64:
+        if (require(8))
+          ptr_ += 8;
+        break;
+      case length_delimited:
+        read_string();
+        break;
+      case fixed32:
+        if (require(4))
+          ptr_ += 4;
+        break;
+      default:
+        fail();
+    }
+  }
+
+private:
+  uint32_t field_ = 0;
+  int type_       = 0;
+};
+} // namespace pb
+} // namespace yasio
+#endif
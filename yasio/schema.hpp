@@ -0,0 +1,436 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2020 HALX99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef YASIO__SCHEMA_HPP
+#define YASIO__SCHEMA_HPP
+#include <stddef.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "yasio/obstream.hpp"
+#include "yasio/ibstream.hpp"
+
+/*
+** The compile-time schema serialization of structs, declare the fields by YASIO_SCHEMA in struct:
+**   struct vec3 { float x, y, z; YASIO_SCHEMA(x, y, z) };
+**   struct player { uint32_t id; std::string name; vec3 pos; std::vector<int32_t> items;
+**                   YASIO_SCHEMA(id, name, pos, items) };
+** then yasio::schema::encode(obs, value) and yasio::schema::decode(ibs, value).
+** The wire format: numbers are big endian fixed size, strings and vectors are prefixed with 7 bits
+** encoded count, nested structs are the fields in order.
+** The size of fixed layout types is computed at compile time, the output buffer is reserved
+** exactly once, and the consecutive fixed size fields are written & read as one run with one
+** bounds check.
+*/
+#define YASIO_SCHEMA(...)                                                                          \
+  template <typename _Ar> auto yasio__schema(_Ar& ar)->decltype(ar(__VA_ARGS__))                   \
+  {                                                                                                \
+    return ar(__VA_ARGS__);                                                                        \
+  }                                                                                                \
+  template <typename _Ar> auto yasio__schema(_Ar& ar) const->decltype(ar(__VA_ARGS__))             \
+  {                                                                                                \
+    return ar(__VA_ARGS__);                                                                        \
+  }
+
+namespace yasio
+{
+namespace schema
+{
+template <typename _Ty, typename _Enable = void> struct traits;
+
+namespace detail
+{
+template <typename... _Types> struct field_list
+{};
+
+// Captures the field types of YASIO_SCHEMA at compile time, never called
+struct type_probe
+{
+  template <typename... _Types>
+  field_list<typename std::decay<_Types>::type...> operator()(_Types&&...) const;
+};
+
+template <typename _Ty>
+using fields_of = decltype(std::declval<_Ty&>().yasio__schema(std::declval<type_probe&>()));
+
+template <typename _Ty, typename _Enable = void> struct has_schema : std::false_type
+{};
+template <typename _Ty>
+struct has_schema<_Ty, typename std::enable_if<(sizeof(fields_of<_Ty>) > 0)>::type>
+    : std::true_type
+{};
+
+// The total size of fields if all are fixed size, otherwise 0
+template <typename _List> struct all_fixed_size;
+template <> struct all_fixed_size<field_list<>>
+{
+  static const size_t value = 0;
+};
+template <typename _Ty> struct all_fixed_size<field_list<_Ty>>
+{
+  static const size_t value = traits<_Ty>::fixed_size;
+};
+template <typename _Ty, typename... _Rest> struct all_fixed_size<field_list<_Ty, _Rest...>>
+{
+  static const size_t rest  = all_fixed_size<field_list<_Rest...>>::value;
+  static const size_t value = traits<_Ty>::fixed_size && rest ? traits<_Ty>::fixed_size + rest : 0;
+};
+
+// The size of leading consecutive fixed size fields
+template <typename... _Types> struct leading_fixed_size
+{
+  static const size_t value = 0;
+};
+template <typename _Ty, typename... _Rest> struct leading_fixed_size<_Ty, _Rest...>
+{
+  static const size_t value =
+      traits<_Ty>::fixed_size ? traits<_Ty>::fixed_size + leading_fixed_size<_Rest...>::value : 0;
+};
+
+template <size_t _Size> using size_constant = std::integral_constant<size_t, _Size>;
+template <bool _Value> using bool_constant  = std::integral_constant<bool, _Value>;
+
+inline size_t varint_size(uint64_t value)
+{
+  size_t n = 1;
+  for (; value >= 0x80; value >>= 7)
+    ++n;
+  return n;
+}
+
+/// encode
+inline void encode_fields(obstream&) {}
+template <typename _Ty, typename... _Rest>
+void encode_fields(obstream& obs, const _Ty& value, const _Rest&... rest);
+
+inline void put_run(char*, obstream&) {}
+template <typename _Ty, typename... _Rest>
+void put_run(char* ptr, obstream& obs, const _Ty& value, const _Rest&... rest);
+template <typename _Ty, typename... _Rest>
+void put_run(bool_constant<true>, char* ptr, obstream& obs, const _Ty& value, const _Rest&... rest)
+{
+  traits<_Ty>::put(ptr, value);
+  put_run(ptr + traits<_Ty>::fixed_size, obs, rest...);
+}
+template <typename... _Types>
+void put_run(bool_constant<false>, char*, obstream& obs, const _Types&... values)
+{ // the run ends at a variable size field
+  encode_fields(obs, values...);
+}
+template <typename _Ty, typename... _Rest>
+void put_run(char* ptr, obstream& obs, const _Ty& value, const _Rest&... rest)
+{
+  put_run(bool_constant<traits<_Ty>::fixed_size != 0>{}, ptr, obs, value, rest...);
+}
+
+template <typename _Ty, typename... _Rest>
+void encode_run(size_constant<0>, obstream& obs, const _Ty& value, const _Rest&... rest)
+{
+  traits<_Ty>::encode(obs, value);
+  encode_fields(obs, rest...);
+}
+template <size_t _Run, typename... _Types>
+void encode_run(size_constant<_Run>, obstream& obs, const _Types&... values)
+{ // grow the buffer once for the run of fixed size fields
+  auto offset = obs.length();
+  obs.buffer().resize(offset + _Run);
+  put_run(obs.wptr(offset), obs, values...);
+}
+template <typename _Ty, typename... _Rest>
+void encode_fields(obstream& obs, const _Ty& value, const _Rest&... rest)
+{
+  encode_run(size_constant<leading_fixed_size<_Ty, _Rest...>::value>{}, obs, value, rest...);
+}
+
+/// decode
+inline void decode_fields(checked_ibstream_view&) {}
+template <typename _Ty, typename... _Rest>
+void decode_fields(checked_ibstream_view& ibs, _Ty& value, _Rest&... rest);
+
+inline void get_run(checked_ibstream_view&) {}
+template <typename _Ty, typename... _Rest>
+void get_run(checked_ibstream_view& ibs, _Ty& value, _Rest&... rest);
+template <typename _Ty, typename... _Rest>
+void get_run(bool_constant<true>, checked_ibstream_view& ibs, _Ty& value, _Rest&... rest)
+{
+  traits<_Ty>::get(ibs, value);
+  get_run(ibs, rest...);
+}
+template <typename... _Types>
+void get_run(bool_constant<false>, checked_ibstream_view& ibs, _Types&... values)
+{
+  decode_fields(ibs, values...);
+}
+template <typename _Ty, typename... _Rest>
+void get_run(checked_ibstream_view& ibs, _Ty& value, _Rest&... rest)
+{
+  get_run(bool_constant<traits<_Ty>::fixed_size != 0>{}, ibs, value, rest...);
+}
+
+template <typename _Ty, typename... _Rest>
+void decode_run(size_constant<0>, checked_ibstream_view& ibs, _Ty& value, _Rest&... rest)
+{
+  traits<_Ty>::decode(ibs, value);
+  decode_fields(ibs, rest...);
+}
+template <size_t _Run, typename... _Types>
+void decode_run(size_constant<_Run>, checked_ibstream_view& ibs, _Types&... values)
+{ // one bounds check for the run of fixed size fields
+  if (ibs.require(_Run))
+    get_run(ibs, values...);
+}
+template <typename _Ty, typename... _Rest>
+void decode_fields(checked_ibstream_view& ibs, _Ty& value, _Rest&... rest)
+{
+  decode_run(size_constant<leading_fixed_size<_Ty, _Rest...>::value>{}, ibs, value, rest...);
+}
+
+/// the visitors of YASIO_SCHEMA fields
+struct sizer
+{
+  size_t size;
+  void operator()() {}
+  template <typename... _Types> void operator()(const _Types&... values)
+  {
+    size_t sizes[] = {traits<_Types>::size(values)...};
+    for (auto n : sizes)
+      size += n;
+  }
+};
+struct encoder
+{
+  obstream& obs;
+  template <typename... _Types> void operator()(const _Types&... values)
+  {
+    encode_fields(obs, values...);
+  }
+};
+struct decoder
+{
+  checked_ibstream_view& ibs;
+  template <typename... _Types> void operator()(_Types&... values)
+  {
+    decode_fields(ibs, values...);
+  }
+};
+struct putter
+{
+  char* ptr;
+  void operator()() {}
+  template <typename... _Types> void operator()(const _Types&... values)
+  {
+    int expand[] = {(traits<_Types>::put(ptr, values), ptr += traits<_Types>::fixed_size, 0)...};
+    (void)expand;
+  }
+};
+struct getter
+{
+  checked_ibstream_view& ibs;
+  void operator()() {}
+  template <typename... _Types> void operator()(_Types&... values)
+  {
+    int expand[] = {(traits<_Types>::get(ibs, values), 0)...};
+    (void)expand;
+  }
+};
+} // namespace detail
+
+/*
+** The traits of serializable types:
+**   fixed_size: the encoded size if it's fixed, otherwise 0
+**   size: the encoded size of a value
+**   encode/decode: write/read a value, the decode failure is reported by the stream error flag
+**   put/get: write/read a fixed size value without bounds check
+** remark: the numbers are converted by span of sizeof, not write_i/read_i, which only specialize
+** the fixed width integers, so char, long long, wchar_t and so on round trip too.
+*/
+template <typename _Ty>
+struct traits<_Ty, typename std::enable_if<std::is_arithmetic<_Ty>::value>::type>
+{
+  static const size_t fixed_size = sizeof(_Ty);
+  static size_t size(const _Ty&) { return sizeof(_Ty); }
+  static void put(char* ptr, const _Ty& value)
+  {
+    yasio::endian::convert_array<sizeof(_Ty)>(ptr, &value, 1);
+  }
+  static void get(checked_ibstream_view& ibs, _Ty& value) { ibs.read_array_unchecked(&value, 1); }
+  static void encode(obstream& obs, const _Ty& value) { obs.write_array(&value, 1); }
+  static void decode(checked_ibstream_view& ibs, _Ty& value) { ibs.read_array(&value, 1); }
+};
+
+template <typename _Ty> struct traits<_Ty, typename std::enable_if<std::is_enum<_Ty>::value>::type>
+{
+  typedef typename std::underlying_type<_Ty>::type value_type;
+  static const size_t fixed_size = sizeof(value_type);
+  static size_t size(const _Ty&) { return sizeof(value_type); }
+  static void put(char* ptr, const _Ty& value)
+  {
+    traits<value_type>::put(ptr, static_cast<value_type>(value));
+  }
+  static void get(checked_ibstream_view& ibs, _Ty& value)
+  {
+    value_type underlying_value;
+    traits<value_type>::get(ibs, underlying_value);
+    value = static_cast<_Ty>(underlying_value);
+  }
+  static void encode(obstream& obs, const _Ty& value)
+  {
+    traits<value_type>::encode(obs, static_cast<value_type>(value));
+  }
+  static void decode(checked_ibstream_view& ibs, _Ty& value)
+  {
+    value_type underlying_value{};
+    traits<value_type>::decode(ibs, underlying_value);
+    value = static_cast<_Ty>(underlying_value);
+  }
+};
+
+template <> struct traits<std::string>
+{
+  static const size_t fixed_size = 0;
+  static size_t size(const std::string& value)
+  {
+    return detail::varint_size(value.size()) + value.size();
+  }
+  static void encode(obstream& obs, const std::string& value) { obs.write_va(value); }
+  static void decode(checked_ibstream_view& ibs, std::string& value)
+  {
+    auto sv = ibs.read_va();
+    value.assign(sv.data(), sv.size());
+  }
+};
+
+template <typename _Ty> struct traits<std::vector<_Ty>>
+{
+  // The bits packed std::vector<bool> has no data() and its elements are not references
+  static_assert(!std::is_same<_Ty, bool>::value, "std::vector<bool> is not supported");
+  static const size_t fixed_size = 0;
+  static size_t size(const std::vector<_Ty>& values)
+  {
+    size_t n = detail::varint_size(values.size());
+    if (traits<_Ty>::fixed_size)
+      return n + traits<_Ty>::fixed_size * values.size();
+    for (auto& value : values)
+      n += traits<_Ty>::size(value);
+    return n;
+  }
+  static void encode(obstream& obs, const std::vector<_Ty>& values)
+  {
+    obs.write_i7(static_cast<int>(values.size()));
+    encode_elements(std::is_arithmetic<_Ty>{}, obs, values);
+  }
+  static void decode(checked_ibstream_view& ibs, std::vector<_Ty>& values)
+  {
+    auto count = static_cast<uint32_t>(ibs.read_i7());
+    if (count > ibs.remain()) // every element is 1 byte at least
+    {
+      ibs.require(count);
+      return;
+    }
+    values.resize(count);
+    decode_elements(std::is_arithmetic<_Ty>{}, ibs, values);
+  }
+
+private:
+  static void encode_elements(std::true_type, obstream& obs, const std::vector<_Ty>& values)
+  {
+    obs.write_array(values.data(), values.size());
+  }
+  static void encode_elements(std::false_type, obstream& obs, const std::vector<_Ty>& values)
+  {
+    for (auto& value : values)
+      traits<_Ty>::encode(obs, value);
+  }
+  static void decode_elements(std::true_type, checked_ibstream_view& ibs, std::vector<_Ty>& values)
+  {
+    ibs.read_array(values.data(), values.size());
+  }
+  static void decode_elements(std::false_type, checked_ibstream_view& ibs,
+                              std::vector<_Ty>& values)
+  {
+    for (auto& value : values)
+      traits<_Ty>::decode(ibs, value);
+  }
+};
+
+template <typename _Ty>
+struct traits<_Ty, typename std::enable_if<detail::has_schema<_Ty>::value>::type>
+{
+  static const size_t fixed_size = detail::all_fixed_size<detail::fields_of<_Ty>>::value;
+  static size_t size(const _Ty& value)
+  {
+    if (fixed_size)
+      return fixed_size;
+    detail::sizer ar{0};
+    value.yasio__schema(ar);
+    return ar.size;
+  }
+  static void put(char* ptr, const _Ty& value)
+  {
+    detail::putter ar{ptr};
+    value.yasio__schema(ar);
+  }
+  static void get(checked_ibstream_view& ibs, _Ty& value)
+  {
+    detail::getter ar{ibs};
+    value.yasio__schema(ar);
+  }
+  static void encode(obstream& obs, const _Ty& value)
+  {
+    detail::encoder ar{obs};
+    value.yasio__schema(ar);
+  }
+  static void decode(checked_ibstream_view& ibs, _Ty& value)
+  {
+    detail::decoder ar{ibs};
+    value.yasio__schema(ar);
+  }
+};
+
+// Gets the encoded size of a value
+template <typename _Ty> inline size_t encoded_size(const _Ty& value)
+{
+  return traits<_Ty>::size(value);
+}
+
+// Encodes a value to the stream, the buffer is reserved once for the whole value
+template <typename _Ty> inline void encode(obstream& obs, const _Ty& value)
+{
+  obs.buffer().reserve(obs.length() + encoded_size(value));
+  traits<_Ty>::encode(obs, value);
+}
+
+// Decodes a value from the stream, returns false if the stream is truncated or malformed
+template <typename _Ty> inline bool decode(checked_ibstream_view& ibs, _Ty& value)
+{
+  traits<_Ty>::decode(ibs, value);
+  return ibs.ok();
+}
+} // namespace schema
+} // namespace yasio
+#endif
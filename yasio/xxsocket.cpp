@@ -724,6 +724,109 @@ int xxsocket::pserv(const char* addr, u_short port)
   return this->listen();
 }
 
+int xxsocket::connect_all(const std::vector<endpoint>& endpoints,
+                          std::vector<connect_result>& results,
+                          const std::chrono::microseconds& wtimeout)
+{
+  results.assign(endpoints.size(), connect_result{});
+
+  std::vector<pollfd> fds;
+  std::vector<size_t> pending; // the target index of fds
+  int connected = 0;
+  auto deadline = highp_clock() + wtimeout.count();
+  for (size_t i = 0; i < endpoints.size(); ++i)
+  {
+    auto& ep     = endpoints[i];
+    auto& result = results[i];
+    result.rtt   = highp_clock(); // the start time until completed
+    auto s       = ::socket(ep.af(), SOCK_STREAM, 0);
+    if (s == invalid_socket)
+    {
+      result.error = xxsocket::get_last_errno();
+      result.rtt   = 0;
+      continue;
+    }
+    if (xxsocket::connect_n(s, ep) == 0)
+    { /* connect completed immediately */
+      result.fd    = s;
+      result.error = 0;
+      result.rtt   = highp_clock() - result.rtt;
+      ++connected;
+      continue;
+    }
+    int error = xxsocket::get_last_errno();
+    if (error != EINPROGRESS && error != EWOULDBLOCK)
+    {
+      ::closesocket(s);
+      result.error = error;
+      result.rtt   = 0;
+      continue;
+    }
+    result.fd = s;
+    pollfd pfd;
+    pfd.fd      = s;
+    pfd.events  = POLLOUT;
+    pfd.revents = 0;
+    fds.push_back(pfd);
+    pending.push_back(i);
+  }
+
+  while (!fds.empty())
+  {
+    auto wait_duration = deadline - highp_clock();
+    if (wait_duration <= 0)
+      break;
+    int n = ::poll(&fds.front(), fds.size(), static_cast<int>((wait_duration + 999) / 1000));
+    if (n < 0 && xxsocket::get_last_errno() != EINTR)
+      break;
+    if (n <= 0)
+      continue;
+
+    auto now = highp_clock();
+    for (size_t k = 0; k < fds.size();)
+    {
+      if (fds[k].revents == 0)
+      {
+        ++k;
+        continue;
+      }
+      auto& result  = results[pending[k]];
+      int error     = 0;
+      socklen_t len = sizeof(error);
+      if (::getsockopt(fds[k].fd, SOL_SOCKET, SO_ERROR, (char*)&error, &len) < 0)
+        error = xxsocket::get_last_errno();
+      result.error = error;
+      result.rtt   = now - result.rtt;
+      if (error == 0)
+        ++connected;
+      else
+      {
+        ::closesocket(result.fd);
+        result.fd = invalid_socket;
+      }
+
+      // remove the completed one, the order of fds doesn't matter
+      fds[k]     = fds.back();
+      pending[k] = pending.back();
+      fds.pop_back();
+      pending.pop_back();
+    }
+  }
+
+  // the not completed targets timeout
+  auto now = highp_clock();
+  for (auto index : pending)
+  {
+    auto& result = results[index];
+    ::closesocket(result.fd);
+    result.fd    = invalid_socket;
+    result.error = ETIMEDOUT;
+    result.rtt   = now - result.rtt;
+  }
+
+  return connected;
+}
+
 int xxsocket::resolve(std::vector<endpoint>& endpoints, const char* hostname, unsigned short port,
                       int socktype)
 {
@@ -1183,6 +1286,41 @@ int xxsocket::send(socket_native_type s, const void* buf, int len, int flags)
   return static_cast<int>(::send(s, (const char*)buf, len, flags));
 }
 
+int xxsocket::sendv(const cxx17::string_view* bufs, int count, int flags) const
+{
+  return xxsocket::sendv(this->fd, bufs, count, flags);
+}
+
+int xxsocket::sendv(socket_native_type s, const cxx17::string_view* bufs, int count, int flags)
+{
+  if (count > YASIO_MAX_IOV)
+    count = YASIO_MAX_IOV;
+#if defined(_WIN32)
+  WSABUF iov[YASIO_MAX_IOV];
+  for (int i = 0; i < count; ++i)
+  {
+    iov[i].buf = (CHAR*)bufs[i].data();
+    iov[i].len = static_cast<ULONG>(bufs[i].size());
+  }
+  DWORD bytes_sent = 0;
+  if (::WSASend(s, iov, count, &bytes_sent, flags, nullptr, nullptr) != 0)
+    return -1;
+  return static_cast<int>(bytes_sent);
+#else
+  struct iovec iov[YASIO_MAX_IOV];
+  for (int i = 0; i < count; ++i)
+  {
+    iov[i].iov_base = (void*)bufs[i].data();
+    iov[i].iov_len  = bufs[i].size();
+  }
+  struct msghdr msg;
+  ::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov    = iov;
+  msg.msg_iovlen = count;
+  return static_cast<int>(::sendmsg(s, &msg, flags));
+#endif
+}
+
 int xxsocket::recv(void* buf, int len, int flags) const
 {
   return static_cast<int>(this->recv(this->fd, buf, len, flags));
@@ -1333,6 +1471,43 @@ void xxsocket::reuse_address(bool reuse)
   }
 }
 
+int xxsocket::set_dontfrag(int af)
+{
+#if defined(IP_MTU_DISCOVER) && defined(IP_PMTUDISC_PROBE) // linux,android
+  if (af == AF_INET6)
+    return this->set_optval(IPPROTO_IPV6, IPV6_MTU_DISCOVER, (int)IPV6_PMTUDISC_PROBE);
+  return this->set_optval(IPPROTO_IP, IP_MTU_DISCOVER, (int)IP_PMTUDISC_PROBE);
+#elif defined(IP_DONTFRAGMENT) // win32
+#  if defined(IPV6_DONTFRAG)
+  if (af == AF_INET6)
+    return this->set_optval(IPPROTO_IPV6, IPV6_DONTFRAG, (int)1);
+#  endif
+  return af == AF_INET ? this->set_optval(IPPROTO_IP, IP_DONTFRAGMENT, (int)1) : -1;
+#elif defined(IP_DONTFRAG) // macos,ios,bsd
+#  if defined(IPV6_DONTFRAG)
+  if (af == AF_INET6)
+    return this->set_optval(IPPROTO_IPV6, IPV6_DONTFRAG, (int)1);
+#  endif
+  return af == AF_INET ? this->set_optval(IPPROTO_IP, IP_DONTFRAG, (int)1) : -1;
+#else
+  (void)af;
+  return -1;
+#endif
+}
+
+int xxsocket::get_path_mtu(int af) const
+{
+  int mtu = -1;
+#if defined(IP_MTU) && defined(IPV6_MTU) // linux,android
+  if ((af == AF_INET6 ? this->get_optval(IPPROTO_IPV6, IPV6_MTU, mtu)
+                      : this->get_optval(IPPROTO_IP, IP_MTU, mtu)) != 0)
+    mtu = -1;
+#else
+  (void)af;
+#endif
+  return mtu;
+}
+
 xxsocket::operator socket_native_type(void) const { return this->fd; }
 
 bool xxsocket::alive(void) const { return this->send("", 0) != -1; }
@@ -38,6 +38,7 @@ SOFTWARE.
 #include <vector>
 #include <chrono>
 #include "yasio/detail/config.hpp"
+#include "yasio/cxx17/string_view.hpp"
 
 #if defined(_MSC_VER)
 #  pragma warning(push)
@@ -73,6 +74,7 @@ typedef int socklen_t;
 #  endif
 #  include <sys/select.h>
 #  include <sys/socket.h>
+#  include <sys/uio.h>
 #  include <netinet/in.h>
 #  include <netinet/tcp.h>
 #  include <net/if.h>
@@ -593,6 +595,28 @@ public: /// portable connect APIs
   // easy to create a tcp ipv4 or ipv6 server socket.
   YASIO__DECL int pserv(const char* addr, u_short port);
 
+  // The per target result of connect_all
+  struct connect_result
+  {
+    socket_native_type fd = invalid_socket; // the connected socket, owned by caller
+    int error             = ETIMEDOUT;      // 0: connected, otherwise the errno
+    long long rtt         = 0;              // the connect elapsed time, microseconds
+  };
+
+  /* @brief: Starts tcp nonblocking connects to all endpoints at once, and waits them with one
+  **         poll, so the total time is the slowest connect instead of the sum.
+  ** @params:
+  **        endpoints: the targets
+  **        results: the result of each target, in the same order of endpoints
+  **        wtimeout: the max time to wait all connects, the not completed will be closed with
+  **                  error ETIMEDOUT
+  ** @returns: the count of connected targets
+  ** @remark: the connected sockets leave in nonblocking mode, caller should close them.
+  */
+  YASIO__DECL static int connect_all(const std::vector<endpoint>& endpoints,
+                                     std::vector<connect_result>& results,
+                                     const std::chrono::microseconds& wtimeout);
+
 public:
   // Construct a empty socket object
   YASIO__DECL xxsocket(void);
@@ -781,6 +805,17 @@ public:
   YASIO__DECL int send(const void* buf, int len, int flags = 0) const;
   YASIO__DECL static int send(socket_native_type fd, const void* buf, int len, int flags = 0);
 
+  /* @brief: Sends the buffers on this connected socket with one system call (sendmsg/WSASend)
+  ** @params:
+  **        'bufs': the buffers to gather, at most YASIO_MAX_IOV buffers are sent a time
+  **
+  ** @returns:
+  **         Same as send, the total bytes sent may less than the buffers.
+  */
+  YASIO__DECL int sendv(const cxx17::string_view* bufs, int count, int flags = 0) const;
+  YASIO__DECL static int sendv(socket_native_type fd, const cxx17::string_view* bufs, int count,
+                               int flags = 0);
+
   /* @brief: Receives data from this connected socket or a bound connectionless socket.
   ** @params: omit
   **
@@ -852,6 +887,20 @@ public:
 
   YASIO__DECL void reuse_address(bool reuse);
 
+  /* @brief: Sets the don't fragment bit of outgoing datagrams and ignores the cached path mtu,
+  **         the datagrams larger than path mtu will be dropped instead of fragmented.
+  ** @params : af: The address family of the socket
+  ** @returns: [0].successfully
+  **          [<0].not supported by the platform or errors occured
+  */
+  YASIO__DECL int set_dontfrag(int af);
+
+  /* @brief: Gets the mtu of the route to the connected peer, includes ip header
+  ** @returns: [>0].the mtu
+  **          [<0].not connected or not supported by the platform
+  */
+  YASIO__DECL int get_path_mtu(int af) const;
+
   /* @brief: Sets the socket option
   ** @params :
   **        level: The level at which the option is defined (for example, SOL_SOCKET).
@@ -1065,16 +1114,31 @@ private:
 namespace net = inet;
 } // namespace yasio
 
+#if defined(_MSC_VER) && _MSC_VER < 1900
 namespace std
 { // VS2013 the operator must be at namespace std
+#else
+namespace yasio
+{
+namespace inet
+{
+namespace ip
+{ // The operator must be found by ADL, so std::less works for all compilers
+#endif
 inline bool operator<(const yasio::inet::ip::endpoint& lhs, const yasio::inet::ip::endpoint& rhs)
 { // apply operator < to operands
   if (lhs.af() == AF_INET)
-    return (static_cast<uint64_t>(lhs.in4_.sin_addr.s_addr) + lhs.in4_.sin_port) <
-           (static_cast<uint64_t>(rhs.in4_.sin_addr.s_addr) + rhs.in4_.sin_port);
+    return ((static_cast<uint64_t>(lhs.in4_.sin_addr.s_addr) << 16) | lhs.in4_.sin_port) <
+           ((static_cast<uint64_t>(rhs.in4_.sin_addr.s_addr) << 16) | rhs.in4_.sin_port);
   return ::memcmp(&lhs, &rhs, sizeof(rhs)) < 0;
 }
+#if defined(_MSC_VER) && _MSC_VER < 1900
 } // namespace std
+#else
+} // namespace ip
+} // namespace inet
+} // namespace yasio
+#endif
 
 #if defined(_MSC_VER)
 #  pragma warning(pop)
@@ -34,7 +34,9 @@ SOFTWARE.
 #  include "yasio/yasio.hpp"
 #endif
 #include <limits>
+#include <random>
 #include <sstream>
+#include "yasio/obstream.hpp"
 #if defined(_WIN32)
 #  include <io.h>
 #  define YASIO_O_OPEN_FLAGS O_CREAT | O_RDWR | O_BINARY, S_IWRITE | S_IREAD
@@ -104,6 +106,7 @@ enum
   YERR_NO_AVAIL_ADDR        = -497, // No available address to connect.
   YERR_LOCAL_SHUTDOWN       = -496, // Local shutdown the connection.
   YERR_SSL_HANDSHAKE_FAILED = -495, // SSL handshake fail
+  YERR_KCP_SEND_FAILED      = -494, // KCP can't send the message.
 };
 
 // event mask
@@ -142,8 +145,168 @@ enum
 
   /* Whether ssl client in handshaking */
   YCPF_SSL_HANDSHAKING = 1 << 19,
+
+  /* Whether client waiting to reconnect, see YOPT_C_RECONNECT */
+  YCPF_RECONNECTING = 1 << 20,
+};
+
+#if defined(YASIO_HAVE_KCP)
+/* The kcp handshake packets, the leading conv is always 0 and both are shorter than the kcp
+** segment header, so they never be confused with kcp segments:
+**   SYN:     [conv:0][magic][nonce]
+**   SYN-ACK: [conv:0][magic][nonce][conv]
+*/
+enum
+{
+  YKCP_OVERHEAD        = 24,  // The kcp segment header size
+  YKCP_CMD_PUSH        = 81,  // The kcp data segment
+  YKCP_MAX_FRAGMENTS   = 127, // ikcp_send fails when the fragments reach IKCP_WND_RCV(128)
+  YKCP_SYN_SIZE        = 12,
+  YKCP_SYN_ACK_SIZE    = 16,
+  YKCP_HANDSHAKE_MAGIC = 0x594B4350, // 'YKCP'
+};
+
+// The SYN when conv is 0, otherwise SYN-ACK, returns the packet size
+inline int yasio__kcp_handshake_encode(char* buf, uint32_t nonce, uint32_t conv)
+{
+  uint32_t fields[4] = {0, yasio::endian::htonv(static_cast<uint32_t>(YKCP_HANDSHAKE_MAGIC)),
+                        yasio::endian::htonv(nonce), yasio::endian::htonv(conv)};
+  int n = conv != 0 ? YKCP_SYN_ACK_SIZE : YKCP_SYN_SIZE;
+  ::memcpy(buf, fields, n);
+  return n;
+}
+inline bool yasio__kcp_handshake_decode(const char* buf, int n, uint32_t& nonce, uint32_t& conv)
+{
+  if (n != YKCP_SYN_SIZE && n != YKCP_SYN_ACK_SIZE)
+    return false;
+  uint32_t fields[4] = {0};
+  ::memcpy(fields, buf, n);
+  if (fields[0] != 0 ||
+      yasio::endian::ntohv(fields[1]) != static_cast<uint32_t>(YKCP_HANDSHAKE_MAGIC))
+    return false;
+  nonce = yasio::endian::ntohv(fields[2]);
+  conv  = yasio::endian::ntohv(fields[3]);
+  return true;
+}
+// Tests whether the datagram carries the segment kcp waits for, the segment header is little
+// endian: [conv:4][cmd:1][frg:1][wnd:2][ts:4][sn:4][una:4][len:4]
+inline bool yasio__kcp_has_next_push(const char* data, int len, uint32_t rcv_nxt)
+{
+  auto load32 = [](const uint8_t* p) -> uint32_t {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+  };
+  auto p = reinterpret_cast<const uint8_t*>(data);
+  while (len >= YKCP_OVERHEAD)
+  {
+    if (p[4] == YKCP_CMD_PUSH && load32(p + 12) == rcv_nxt)
+      return true;
+    uint32_t size = load32(p + 20);
+    if (size > static_cast<uint32_t>(len - YKCP_OVERHEAD))
+      break;
+    p += YKCP_OVERHEAD + size;
+    len -= YKCP_OVERHEAD + static_cast<int>(size);
+  }
+  return false;
+}
+inline uint32_t yasio__kcp_random_conv()
+{
+  std::random_device rd;
+  return static_cast<uint32_t>(rd());
+}
+#endif
+
+/* The path mtu probe packets, the leading 0 and the magic make them never be confused with kcp
+** segments, kcp handshake packets and fec shards:
+**   PROBE: [0][magic][size][padding to size]
+**   ACK:   [0][magic][size]
+*/
+enum
+{
+  YPMTU_HEADER_SIZE = 12,
+  YPMTU_PROBE_MAGIC = 0x594D5450, // 'YMTP'
+  YPMTU_ACK_MAGIC   = 0x594D5441, // 'YMTA'
+};
+inline int yasio__pmtu_encode(char* buf, uint32_t magic, int size)
+{
+  uint32_t fields[3] = {0, yasio::endian::htonv(magic),
+                        yasio::endian::htonv(static_cast<uint32_t>(size))};
+  ::memcpy(buf, fields, sizeof(fields));
+  return YPMTU_HEADER_SIZE;
+}
+// Returns the magic of the probe packet, 0 if it's not a probe packet
+inline uint32_t yasio__pmtu_decode(const char* buf, int n, int& size)
+{
+  if (n < YPMTU_HEADER_SIZE)
+    return 0;
+  uint32_t fields[3];
+  ::memcpy(fields, buf, sizeof(fields));
+  if (fields[0] != 0)
+    return 0;
+  auto magic = yasio::endian::ntohv(fields[1]);
+  size       = static_cast<int>(yasio::endian::ntohv(fields[2]));
+  if (magic == YPMTU_PROBE_MAGIC)
+    return size == n ? magic : 0;
+  return (magic == YPMTU_ACK_MAGIC && n == YPMTU_HEADER_SIZE) ? magic : 0;
+}
+
+// Interleaves the address families start with the first one, see RFC 8305 section 4
+inline void yasio__interleave_families(std::vector<ip::endpoint>& endpoints)
+{
+  auto af     = endpoints.front().af();
+  auto others = std::stable_partition(endpoints.begin(), endpoints.end(),
+                                      [=](const ip::endpoint& ep) { return ep.af() == af; });
+  if (others == endpoints.end())
+    return;
+  std::vector<ip::endpoint> result;
+  result.reserve(endpoints.size());
+  auto first = endpoints.begin(), second = others;
+  while (first != others || second != endpoints.end())
+  {
+    if (first != others)
+      result.push_back(*first++);
+    if (second != endpoints.end())
+      result.push_back(*second++);
+  }
+  endpoints.swap(result);
+}
+
+#if defined(YASIO_HAVE_SSL)
+// The ssl handshake step results
+enum
+{
+  YSSL_HANDSHAKE_FAILED = -1,
+  YSSL_HANDSHAKE_WANT_READ,
+  YSSL_HANDSHAKE_WANT_WRITE,
+  YSSL_HANDSHAKE_OK,
 };
 
+// Runs a handshake step, it's safe to call at any thread, but never at two threads concurrently
+inline int yasio__ssl_handshake(SSL* ssl)
+{
+  int ret = ::SSL_do_handshake(ssl);
+  if (ret == 1)
+    return YSSL_HANDSHAKE_OK;
+  switch (::SSL_get_error(ssl, ret))
+  {
+    case SSL_ERROR_WANT_READ:
+      return YSSL_HANDSHAKE_WANT_READ;
+    case SSL_ERROR_WANT_WRITE:
+      return YSSL_HANDSHAKE_WANT_WRITE;
+    default:
+      ::ERR_clear_error(); // the error queue is per thread
+      return YSSL_HANDSHAKE_FAILED;
+  }
+}
+#endif
+
+// The splitmix64 finalizer, makes a well distributed random number from a seed
+inline uint64_t yasio__mix64(uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
 #define YDQS_CHECK_STATE(what, value) ((what & 0x00ff) == value)
 #define YDQS_SET_STATE(what, value) (what = (what & 0xff00) | value)
 #define YDQS_GET_STATE(what) (what & 0x00ff)
@@ -233,9 +396,45 @@ public:
   a_pdu(std::vector<char>&& buffer, std::function<void()>&& handler)
       : rpos_(0), buffer_(std::move(buffer)), handler_(std::move(handler))
   {}
+  a_pdu(chain_obstream&& obs, std::function<void()>&& handler)
+      : rpos_(0), ref_size_(obs.length() - obs.buffer().size()), buffer_(std::move(obs.buffer())),
+        refs_(std::move(obs.refs())), owners_(std::move(obs.owners())), handler_(std::move(handler))
+  {}
+  ~a_pdu() { obstream_pool::recycle(std::move(buffer_)); }
+
+  size_t size() const { return buffer_.size() + ref_size_; }
+
+  // Gathers the outstanding segments from rpos_
+  int gather(cxx17::string_view* bufs, int max_count) const
+  {
+    int count  = 0;
+    size_t pos = 0, offset = 0;
+    auto append = [&](const char* data, size_t size) {
+      if (size > 0 && pos + size > rpos_)
+      {
+        auto skip     = rpos_ > pos ? rpos_ - pos : 0;
+        bufs[count++] = cxx17::string_view(data + skip, size - skip);
+      }
+      pos += size;
+    };
+    for (auto& ref : refs_)
+    {
+      append(buffer_.data() + offset, ref.offset - offset);
+      if (count < max_count)
+        append(ref.data, ref.size);
+      if (count >= max_count)
+        return count;
+      offset = ref.offset;
+    }
+    append(buffer_.data() + offset, buffer_.size() - offset);
+    return count;
+  }
 
   size_t rpos_;              // read pos from sending buffer
+  size_t ref_size_ = 0;      // the bytes of referenced blobs
   std::vector<char> buffer_; // sending data buffer
+  std::vector<chain_obstream::blob_ref> refs_;
+  std::vector<std::shared_ptr<const void>> owners_;
   std::function<void()> handler_;
 #if !defined(YASIO_DISABLE_OBJECT_POOL)
   DEFINE_CONCURRENT_OBJECT_POOL_ALLOCATION(a_pdu, 512)
@@ -271,7 +470,7 @@ io_channel::io_channel(io_service& service, int index) : timer_(service)
   state_             = io_base::state::CLOSED;
   dns_queries_state_ = YDQS_FAILED;
   index_             = index;
-  decode_len_        = [=](void* ptr, int len) { return this->__builtin_decode_len(ptr, len); };
+  configure_decode_len();
 }
 void io_channel::enable_multicast_group(const ip::endpoint& ep, int loopback)
 {
@@ -355,41 +554,30 @@ void io_channel::configure_port(u_short port)
         ep.port(port);
   }
 }
-int io_channel::__builtin_decode_len(void* ud, int n)
+void io_channel::configure_decode_len()
 {
-  if (lfb_.length_field_offset >= 0)
+  if (lfb_.length_field_offset < 0)
   {
-    if (n >= (lfb_.length_field_offset + lfb_.length_field_length))
-    {
-      int32_t length = -1;
-      switch (lfb_.length_field_length)
-      {
-        case 4:
-          length =
-              ntohl(*reinterpret_cast<int32_t*>((unsigned char*)ud + lfb_.length_field_offset)) +
-              lfb_.length_adjustment;
-          break;
-        case 3:
-          length = 0;
-          memcpy(&length, (unsigned char*)ud + lfb_.length_field_offset, 3);
-          length = (ntohl(length) >> 8) + lfb_.length_adjustment;
-          break;
-        case 2:
-          length =
-              ntohs(*reinterpret_cast<uint16_t*>((unsigned char*)ud + lfb_.length_field_offset)) +
-              lfb_.length_adjustment;
-          break;
-        case 1:
-          length = *((unsigned char*)ud + lfb_.length_field_offset) + lfb_.length_adjustment;
-          break;
-      }
-      if (length > lfb_.max_frame_length)
-        length = -1;
-      return length;
-    }
-    return 0;
+    lfb_decode_len_ = lfb_decode_len_directly;
+    return;
+  }
+  switch (lfb_.length_field_length)
+  {
+    case 4:
+      lfb_decode_len_ = lfb_decode_len<4>;
+      break;
+    case 3:
+      lfb_decode_len_ = lfb_decode_len<3>;
+      break;
+    case 2:
+      lfb_decode_len_ = lfb_decode_len<2>;
+      break;
+    case 1:
+      lfb_decode_len_ = lfb_decode_len<1>;
+      break;
+    default: // unsupported length field, every frame fails
+      lfb_decode_len_ = [](const void*, int, int, int, int) { return -1; };
   }
-  return n;
 }
 // -------------------- io_transport ---------------------
 io_transport::io_transport(io_channel* ctx, std::shared_ptr<xxsocket>& s) : ctx_(ctx)
@@ -400,16 +588,45 @@ io_transport::io_transport(io_channel* ctx, std::shared_ptr<xxsocket>& s) : ctx_
   this->socket_                   = s;
   this->ud_.ptr                   = nullptr;
 }
+int io_transport::__builtin_decode_delim(int n)
+{
+  auto& dbf       = ctx_->dbf_;
+  int scan_end    = n - dbf.delimiter_length + 1; // the delimiter starts before it
+  auto delim_rest = dbf.delimiter_length - 1;
+  for (int offset = scan_offset_; offset < scan_end;)
+  { // memchr is vectorized by libc, then compare the rest bytes of delimiter
+    auto hit = static_cast<char*>(::memchr(buffer_ + offset, dbf.delimiter[0], scan_end - offset));
+    if (!hit)
+      break;
+    if (::memcmp(hit + 1, dbf.delimiter + 1, delim_rest) == 0)
+    {
+      scan_offset_ = 0; // the remain bytes are moved to the head and not scanned
+      int length   = static_cast<int>(hit - buffer_) + dbf.delimiter_length;
+      return length <= dbf.max_frame_length ? length : -1;
+    }
+    offset = static_cast<int>(hit - buffer_) + 1;
+  }
+  // the delimiter may straddle the next read, so its leading bytes are scanned again
+  scan_offset_ = (std::max)(scan_offset_, scan_end);
+  return n < (std::min)(dbf.max_frame_length, static_cast<int>(sizeof(buffer_))) ? 0 : -1;
+}
 int io_transport::do_read(int& error)
 {
   int n = read_cb_(buffer_ + wpos_, sizeof(buffer_) - wpos_);
   error = n < 0 ? xxsocket::get_last_errno() : 0;
   return n;
 }
+int io_transport::write_chain(chain_obstream&& obs, std::function<void()>&& handler)
+{
+  return write(obs.flatten(), std::move(handler));
+}
 void io_transport::set_primitives()
 {
-  this->write_cb_ = [=](const void* data, int len) { return socket_->send(data, len); };
-  this->read_cb_  = [=](void* data, int len) { return socket_->recv(data, len, 0); };
+  this->write_cb_  = [=](const void* data, int len) { return socket_->send(data, len); };
+  this->read_cb_   = [=](void* data, int len) { return socket_->recv(data, len, 0); };
+  this->writev_cb_ = [=](const cxx17::string_view* bufs, int count) {
+    return socket_->sendv(bufs, count);
+  };
 }
 // -------------------- io_transport_tcp ---------------------
 inline io_transport_tcp::io_transport_tcp(io_channel* ctx, std::shared_ptr<xxsocket>& s)
@@ -422,6 +639,13 @@ int io_transport_tcp::write(std::vector<char>&& buffer, std::function<void()>&&
   get_service().interrupt();
   return n;
 }
+int io_transport_tcp::write_chain(chain_obstream&& obs, std::function<void()>&& handler)
+{
+  int n = static_cast<int>(obs.length());
+  send_queue_.emplace(std::make_shared<a_pdu>(std::move(obs), std::move(handler)));
+  get_service().interrupt();
+  return n;
+}
 bool io_transport_tcp::do_write(long long& max_wait_duration)
 {
   bool ret = false;
@@ -435,8 +659,15 @@ bool io_transport_tcp::do_write(long long& max_wait_duration)
     if (wrap)
     {
       auto v                 = *wrap;
-      auto outstanding_bytes = static_cast<int>(v->buffer_.size() - v->rpos_);
-      int n                  = write_cb_(v->buffer_.data() + v->rpos_, outstanding_bytes);
+      auto outstanding_bytes = static_cast<int>(v->size() - v->rpos_);
+      int n;
+      if (v->refs_.empty())
+        n = write_cb_(v->buffer_.data() + v->rpos_, outstanding_bytes);
+      else
+      { // scatter-gather, the referenced blobs are sent without copy
+        cxx17::string_view bufs[YASIO_MAX_IOV];
+        n = writev_cb_(bufs, v->gather(bufs, YASIO_MAX_IOV));
+      }
       if (n == outstanding_bytes)
       { // All pdu bytes sent.
         send_queue_.pop();
@@ -455,7 +686,7 @@ bool io_transport_tcp::do_write(long long& max_wait_duration)
       {
         // #performance: change offset only, remain data will be send next loop.
         v->rpos_ += n;
-        outstanding_bytes = static_cast<int>(v->buffer_.size() - v->rpos_);
+        outstanding_bytes = static_cast<int>(v->size() - v->rpos_);
       }
       else
       { // n <= 0
@@ -489,8 +720,35 @@ io_transport_ssl::io_transport_ssl(io_channel* ctx, std::shared_ptr<xxsocket>& s
 }
 void io_transport_ssl::set_primitives()
 {
-  this->read_cb_  = [=](void* data, int len) { return ::SSL_read(ssl_, data, len); };
-  this->write_cb_ = [=](const void* data, int len) { return ::SSL_write(ssl_, data, len); };
+  // The kernel tls receiving still need SSL_read to handle the control records, e.g. the TLS 1.3
+  // tickets, but it doesn't decrypt at userspace.
+  this->read_cb_ = [=](void* data, int len) { return ::SSL_read(ssl_, data, len); };
+#if defined(SSL_OP_ENABLE_KTLS)
+  if (BIO_get_ktls_send(::SSL_get_wbio(ssl_)))
+  { // The kernel encrypts the records, write plaintext to socket without a userspace copy
+    this->write_cb_  = [=](const void* data, int len) { return socket_->send(data, len); };
+    this->writev_cb_ = [=](const cxx17::string_view* bufs, int count) {
+      return socket_->sendv(bufs, count);
+    };
+    return;
+  }
+#endif
+  this->write_cb_  = [=](const void* data, int len) { return ::SSL_write(ssl_, data, len); };
+  this->writev_cb_ = [=](const cxx17::string_view* bufs, int count) {
+    // SSL_write the buffers one by one, stop at the first partial write
+    int bytes_sent = 0;
+    for (int i = 0; i < count; ++i)
+    {
+      int len = static_cast<int>(bufs[i].size());
+      int n   = ::SSL_write(ssl_, bufs[i].data(), len);
+      if (n <= 0)
+        return bytes_sent > 0 ? bytes_sent : n;
+      bytes_sent += n;
+      if (n < len)
+        break;
+    }
+    return bytes_sent;
+  };
 }
 #endif
 // ----------------------- io_transport_udp ----------------
@@ -583,9 +841,114 @@ void io_transport_udp::set_primitives()
     };
   }
 }
+int io_transport_udp::do_read(int& error)
+{
+  int n = io_transport::do_read(error);
+  if (n > 0 && (ctx_->properties_ & YCF_PMTUD) && handle_pmtu_packet(buffer_ + wpos_, n))
+  {
+    n     = -1;
+    error = EWOULDBLOCK;
+  }
+  return n;
+}
 bool io_transport_udp::do_write(long long& max_wait_duration)
 {
-  return !((opmask_ | ctx_->opmask_) & YOPM_CLOSE_TRANSPORT);
+  if ((opmask_ | ctx_->opmask_) & YOPM_CLOSE_TRANSPORT)
+    return false;
+  if ((ctx_->properties_ & YCF_PMTUD) && !pmtu_.done)
+    probe_mtu(max_wait_duration);
+  return true;
+}
+bool io_transport_udp::handle_pmtu_packet(char* data, int len)
+{
+  int size;
+  switch (yasio__pmtu_decode(data, len, size))
+  {
+    case YPMTU_PROBE_MAGIC:
+      write_cb_(data, yasio__pmtu_encode(data, YPMTU_ACK_MAGIC, size));
+      break;
+    case YPMTU_ACK_MAGIC:
+      if (size == pmtu_.probe)
+      {
+        pmtu_.probe = 0;
+        pmtu_.mtu   = size;
+        on_mtu_changed();
+      }
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+void io_transport_udp::probe_mtu(long long& max_wait_duration)
+{
+  auto& pmtu = this->pmtu_;
+  if (pmtu.hi == 0)
+  { // With don't fragment bit, the datagrams larger than path mtu are dropped by router
+    int af = ensure_peer().af();
+    if (af == AF_UNSPEC)
+      return;
+    if (socket_->set_dontfrag(af) != 0)
+    {
+      YASIO_SLOG_IMPL(get_service().options_, "[index: %d] path mtu discovery not supported",
+                      cindex());
+      pmtu.done = true;
+      return;
+    }
+    int path_mtu = connected_ ? socket_->get_path_mtu(af) : -1;
+    pmtu.hi      = (path_mtu > 0 ? path_mtu : 1500) - (af == AF_INET6 ? 48 : 28); // ip,udp header
+#if defined(YASIO_HAVE_KCP)
+    if ((ctx_->properties_ & YCM_KCP) && ctx_->kcp_.mtu > 0)
+      pmtu.hi = (std::min)(pmtu.hi, ctx_->kcp_.mtu);
+#endif
+    if (pmtu.hi < pmtu.mtu)
+    { // The local route is narrower than the base size
+      pmtu.mtu = (std::max)(pmtu.hi, static_cast<int>(YPMTU_HEADER_SIZE));
+      on_mtu_changed();
+    }
+  }
+
+  auto now = highp_clock();
+  if (pmtu.probe != 0 && now >= pmtu.expire)
+  {
+    if (pmtu.tries < YASIO_PMTUD_MAX_PROBES)
+      send_mtu_probe();
+    else
+    { // the probe lost, regards it too large
+      pmtu.hi    = pmtu.probe - 1;
+      pmtu.probe = 0;
+    }
+  }
+  while (pmtu.probe == 0)
+  {
+    if (pmtu.mtu >= pmtu.hi)
+    {
+      YASIO_SLOG_IMPL(get_service().options_, "[index: %d] the path mtu of connection #%u is %d",
+                      cindex(), id_, pmtu.mtu);
+      pmtu.done = true;
+      return;
+    }
+    pmtu.probe = (pmtu.mtu + pmtu.hi + 1) / 2;
+    pmtu.tries = 0;
+    send_mtu_probe();
+  }
+
+  long long wait_duration = (std::max)(pmtu.expire - now, 0LL);
+  if (max_wait_duration > wait_duration)
+    max_wait_duration = wait_duration;
+}
+void io_transport_udp::send_mtu_probe()
+{
+  auto& pmtu = this->pmtu_;
+  std::vector<char> probe(pmtu.probe);
+  yasio__pmtu_encode(&probe.front(), YPMTU_PROBE_MAGIC, pmtu.probe);
+  ++pmtu.tries;
+  pmtu.expire = highp_clock() + YASIO_PMTUD_PROBE_TIMEOUT * 1000LL;
+  if (write_cb_(&probe.front(), pmtu.probe) < 0 && xxsocket::get_last_errno() == EMSGSIZE)
+  { // larger than the mtu of local interface
+    pmtu.hi    = pmtu.probe - 1;
+    pmtu.probe = 0;
+  }
 }
 
 #if defined(YASIO_HAVE_KCP)
@@ -593,55 +956,129 @@ bool io_transport_udp::do_write(long long& max_wait_duration)
 io_transport_kcp::io_transport_kcp(io_channel* ctx, std::shared_ptr<xxsocket>& s)
     : io_transport_udp(ctx, s)
 {
-  this->kcp_ = ::ikcp_create(0, this);
-  ::ikcp_nodelay(this->kcp_, 1, 10 /*MAX_WAIT_DURATION / 1000*/, 2, 1);
+  auto& opts = ctx->kcp_;
+  this->kcp_ = ::ikcp_create(opts.conv, this);
+  ::ikcp_nodelay(this->kcp_, opts.nodelay, opts.interval, opts.resend, opts.nc);
+  if (opts.sndwnd > 0 || opts.rcvwnd > 0)
+    ::ikcp_wndsize(this->kcp_, opts.sndwnd, opts.rcvwnd);
+  // The adaptive send window is limited by the window the peer advertises, and the receiver of
+  // a one way flow is never backlogged to grow it, so advertise the max window from start.
+  if (opts.max_wnd > 0)
+    ::ikcp_wndsize(this->kcp_, 0, (std::max)(opts.rcvwnd, opts.max_wnd));
+  int mtu = opts.mtu;
+  if (ctx->properties_ & YCF_PMTUD) // start with the safe size, grows with the probed path mtu
+    mtu = pmtu_.mtu = opts.mtu > 0 ? (std::min)(opts.mtu, pmtu_.mtu) : pmtu_.mtu;
+  if (mtu > 0)
+    ::ikcp_setmtu(this->kcp_, mtu);
+  if (opts.fec_parity > 0)
+  { // The datagram size is kept by leaving room for fec header
+    fec_encoder_.reset(opts.fec_data, opts.fec_parity);
+    fec_decoder_.reset(opts.fec_data, opts.fec_parity);
+    ::ikcp_setmtu(this->kcp_, static_cast<int>(this->kcp_->mtu) - fec_shard::overhead);
+  }
+  max_message_size_ = static_cast<int>(YKCP_MAX_FRAGMENTS * this->kcp_->mss);
   ::ikcp_setoutput(this->kcp_, [](const char* buf, int len, ::ikcpcb* /*kcp*/, void* user) {
     auto t = (io_transport_kcp*)user;
-    return t->write_cb_(buf, len);
+    if (!t->fec_encoder_.enabled())
+      return t->write_cb_(buf, len);
+    t->fec_encoder_.encode(buf, len, t->write_cb_);
+    return len;
   });
 }
 io_transport_kcp::~io_transport_kcp() { ::ikcp_release(this->kcp_); }
 
 int io_transport_kcp::write(std::vector<char>&& buffer, std::function<void()>&& /*handler*/)
 {
-  std::lock_guard<std::recursive_mutex> lck(send_mtx_);
-  int retval = ::ikcp_send(kcp_, buffer.data(), static_cast<int>(buffer.size()));
+  int n = static_cast<int>(buffer.size());
+  if (n <= 0 || n > max_message_size_)
+  { // kcp can't send it, reject here, otherwise the message is lost silently
+    YASIO_SLOG_IMPL(get_service().options_,
+                    "[index: %d] kcp send failed, message size:%d, max message size:%d", cindex(),
+                    n, max_message_size_.load());
+    return -1;
+  }
+  send_queue_.emplace(std::move(buffer));
   get_service().interrupt();
-  return retval;
+  return n;
 }
 int io_transport_kcp::do_read(int& error)
 {
-  char sbuf[YASIO_INET_BUFFER_SIZE];
-  int n = read_cb_(sbuf, sizeof(sbuf));
-  if (n > 0)
-  { // ikcp in event always in service thread, so no need to lock, TODO: confirm.
-    // 0: ok, -1: again, -3: error
-    if (0 == ::ikcp_input(kcp_, sbuf, n))
+  int n;
+  // The server sessions share the listening socket, see io_service::do_kcp_accept_completion
+  if (!(ctx_->properties_ & YCM_SERVER))
+  {
+    char sbuf[YASIO_INET_BUFFER_SIZE];
+    n = read_cb_(sbuf, sizeof(sbuf));
+    if (n <= 0)
     {
-      n = ::ikcp_recv(kcp_, buffer_ + wpos_, sizeof(buffer_) - wpos_);
-      if (n < 0) // EAGAIN/EWOULDBLOCK
-      {
-        n     = -1;
-        error = EWOULDBLOCK;
-      }
+      error = xxsocket::get_last_errno();
+      return n;
     }
-    else
+    if ((ctx_->properties_ & YCF_PMTUD) && handle_pmtu_packet(sbuf, n))
+    {
+      error = EWOULDBLOCK;
+      return -1;
+    }
+    // ikcp in event always in service thread, so no need to lock, TODO: confirm.
+    // 0: ok, -1: again, -3: error
+    if (0 != kcp_input(sbuf, n))
     { // current, simply regards -1,-3 as error and trigger connection lost event.
-      n     = 0;
       error = YERR_INVALID_PACKET;
+      return 0;
     }
   }
-  else
-    error = xxsocket::get_last_errno();
+  n = ::ikcp_recv(kcp_, buffer_ + wpos_, sizeof(buffer_) - wpos_);
+  if (n < 0) // EAGAIN/EWOULDBLOCK
+  {
+    n     = -1;
+    error = EWOULDBLOCK;
+  }
   return n;
 }
 bool io_transport_kcp::do_write(long long& max_wait_duration)
 {
-  std::lock_guard<std::recursive_mutex> lck(send_mtx_);
+  if (ctx_->properties_ & YCM_SERVER)
+  { // The server sessions never see the errors of the shared socket, close the dead ones
+    int idle_timeout = ctx_->kcp_.idle_timeout;
+    if (kcp_->state == (IUINT32)-1 ||
+        (idle_timeout > 0 && highp_clock() - active_time_ > idle_timeout * 1000LL))
+    {
+      set_last_errno(ETIMEDOUT);
+      return false;
+    }
+  }
+
+  if ((ctx_->properties_ & YCF_PMTUD) && !pmtu_.done)
+    probe_mtu(max_wait_duration);
+
+  // Feed the user messages to kcp, let ikcp_update flush them immediately
+  for (;;)
+  {
+    auto wrap = send_queue_.peek();
+    if (!wrap)
+      break;
+    auto& buffer = *wrap;
+    // -1: empty message, -2: too many fragments, the mss maybe shrunk after write accepted it
+    if (::ikcp_send(kcp_, buffer.data(), static_cast<int>(buffer.size())) < 0)
+    {
+      YASIO_SLOG_IMPL(get_service().options_, "[index: %d] kcp send failed, message size:%d",
+                      cindex(), static_cast<int>(buffer.size()));
+      set_last_errno(YERR_KCP_SEND_FAILED);
+      return false;
+    }
+    send_queue_.pop();
+  }
 
   auto current = static_cast<IUINT32>(highp_clock() / 1000);
   ::ikcp_update(kcp_, current);
 
+  // Close the fec group at the end of kcp flush, so the tail losses can be recovered too
+  if (fec_encoder_.enabled())
+    fec_encoder_.flush(write_cb_);
+
+  if (ctx_->kcp_.max_wnd > 0)
+    adapt_window(current);
+
   auto expire_time        = ::ikcp_check(kcp_, current);
   long long wait_duration = (long long)(expire_time - current) * 1000;
   if (wait_duration < 0)
@@ -652,6 +1089,78 @@ bool io_transport_kcp::do_write(long long& max_wait_duration)
 
   return true;
 }
+int io_transport_kcp::kcp_input(const char* data, int len)
+{
+  if (!fec_decoder_.enabled())
+    return ::ikcp_input(kcp_, data, len);
+
+  // The parity shard which recovers nothing is fine
+  int retval = 0;
+  if (!fec_decoder_.decode(data, len, [&](const char* segment, int size) {
+        if (::ikcp_input(kcp_, segment, size) != 0)
+          retval = -1;
+      }))
+    retval = ::ikcp_input(kcp_, data, len); // not a fec shard, let kcp judge it
+  return retval;
+}
+void io_transport_kcp::on_mtu_changed()
+{
+  int mtu = this->mtu();
+  if (fec_encoder_.enabled())
+    mtu -= fec_shard::overhead;
+  ::ikcp_setmtu(this->kcp_, mtu);
+  max_message_size_ = static_cast<int>(YKCP_MAX_FRAGMENTS * this->kcp_->mss);
+}
+void io_transport_kcp::adapt_window(uint32_t current)
+{
+  if (sample_.ts == 0)
+  { // start the first sample period
+    sample_.ts      = current;
+    sample_.snd_una = kcp_->snd_una;
+    sample_.snd_nxt = kcp_->snd_nxt;
+    sample_.xmit    = kcp_->xmit;
+    return;
+  }
+
+  // The sample period is 2 x srtt, at least 100ms, at most 1s
+  int srtt    = (std::max)(static_cast<int>(kcp_->rx_srtt), 1);
+  auto period = static_cast<int32_t>(current - sample_.ts);
+  if (period < ::yasio::clamp(srtt * 2, 100, 1000))
+    return;
+
+  auto acked = static_cast<int>(kcp_->snd_una - sample_.snd_una);
+  auto sent  = static_cast<int>(kcp_->snd_nxt - sample_.snd_nxt);
+  auto lost  = static_cast<int>(kcp_->xmit - sample_.xmit);
+
+  auto& opts  = ctx_->kcp_;
+  int min_wnd = opts.sndwnd > 0 ? opts.sndwnd : YASIO_KCP_MIN_WND;
+  int wnd     = static_cast<int>(kcp_->snd_wnd);
+  // timeout retransmissions per hundred new segments
+  int loss = sent > 0 ? lost * 100 / sent : (lost > 0 ? 100 : 0);
+  if (loss >= YASIO_KCP_HIGH_LOSS)
+    wnd = (std::max)(min_wnd, wnd * 3 / 4); // back off, the retransmissions eat the bandwidth
+  else if (loss <= YASIO_KCP_LOW_LOSS && kcp_->nsnd_que > 0)
+  { // backlogged: grow to 2 x bandwidth-delay product, at least double the window
+    int bdp = acked * srtt / (std::max)(static_cast<int>(period), 1);
+    wnd     = (std::min)(opts.max_wnd, (std::max)(wnd * 2, bdp * 2));
+  }
+
+  if (wnd != static_cast<int>(kcp_->snd_wnd))
+  {
+    // The receive window is max_wnd already, see io_transport_kcp::io_transport_kcp
+    ::ikcp_wndsize(kcp_, wnd, 0);
+#if defined(YASIO_VERBOSE_LOG)
+    YASIO_SLOG_IMPL(get_service().options_,
+                    "[index: %d] kcp adaptive window: %d, srtt: %d, loss: %d%%", cindex(), wnd,
+                    srtt, loss);
+#endif
+  }
+
+  sample_.ts      = current;
+  sample_.snd_una = kcp_->snd_una;
+  sample_.snd_nxt = kcp_->snd_nxt;
+  sample_.xmit    = kcp_->xmit;
+}
 #endif
 
 // ------------------------ io_service ------------------------
@@ -737,6 +1246,9 @@ void io_service::init(const io_hostent* channel_eps, int channel_count)
   options_.resolv_ = [=](std::vector<ip::endpoint>& eps, const char* host, unsigned short port) {
     return this->builtin_resolv(eps, host, port);
   };
+#if !defined(YASIO_HAVE_CARES)
+  resolv_pool_.set_max_threads(4);
+#endif
 
   register_descriptor(interrupter_.read_descriptor(), YEM_POLLIN);
 
@@ -749,6 +1261,15 @@ void io_service::dispose()
 {
   if (this->state_ == io_service::state::IDLE)
   {
+#if !defined(YASIO_HAVE_CARES)
+    // The resolving tasks use options_.resolv_
+    resolv_pool_.join();
+#endif
+#if defined(YASIO_HAVE_SSL)
+    // The handshaking tasks use the ssl objects of channels
+    ssl_pool_.join();
+    ssl_completions_.clear(); // refers the channels
+#endif
     clear_channels();
     this->events_.clear();
     this->timer_queue_.clear();
@@ -792,6 +1313,10 @@ void io_service::clear_transports()
 {
   for (auto transport : transports_)
   {
+#if defined(YASIO_HAVE_KCP)
+    if ((transport->ctx_->properties_ & YCK_KCP_SERVER) == YCK_KCP_SERVER)
+      unbind_kcp_session(static_cast<io_transport_kcp*>(transport));
+#endif
     cleanup_io(transport);
     transport->~io_transport();
     this->tpool_.push_back(transport);
@@ -851,6 +1376,14 @@ void io_service::run()
 #if defined(YASIO_HAVE_CARES)
     // process possible async resolve requests.
     process_ares_requests(fds_array);
+#else
+    // apply the resolve results of thread pool
+    process_resolv_completions();
+#endif
+
+#if defined(YASIO_HAVE_SSL)
+    // apply the ssl handshake steps of thread pool
+    process_ssl_completions();
 #endif
 
     // process active transports
@@ -948,7 +1481,15 @@ void io_service::process_channels(fd_set* fds_array)
       {
         auto opmask = ctx->opmask_;
         if (opmask & YOPM_CLOSE_CHANNEL)
+        {
+#if defined(YASIO_HAVE_KCP)
+          close_kcp_sessions(ctx);
+#endif
+#if defined(YASIO_HAVE_SSL)
+          close_ssl_accepts(ctx);
+#endif
           cleanup_io(ctx);
+        }
 
         if (opmask & YOPM_OPEN_CHANNEL)
           do_nonblocking_accept(ctx);
@@ -972,6 +1513,12 @@ void io_service::close(int cindex)
   if (!channel)
     return;
 
+  if (channel->properties_ & YCPF_RECONNECTING)
+  { // cancel the pending reconnect
+    channel->properties_ &= ~YCPF_RECONNECTING;
+    channel->timer_.cancel();
+  }
+
   if (!(channel->opmask_ & YOPM_CLOSE_CHANNEL))
   {
     if (close_internal(channel))
@@ -1030,6 +1577,10 @@ void io_service::handle_close(transport_handle_t thandle)
   YASIO_SLOG("[index: %d] the connection #%u is lost, ec=%d, detail:%s", ctx->index_, thandle->id_,
              ec, io_service::strerror(ec));
 
+#if defined(YASIO_HAVE_KCP)
+  if ((ctx->properties_ & YCK_KCP_SERVER) == YCK_KCP_SERVER)
+    unbind_kcp_session(static_cast<io_transport_kcp*>(thandle));
+#endif
   cleanup_io(thandle, false);
 
   deallocate_transport(thandle);
@@ -1045,6 +1596,9 @@ void io_service::handle_close(transport_handle_t thandle)
 
   // @Notify connection lost
   this->handle_event(event_ptr(new io_event(ctx->index_, YEK_CONNECTION_LOST, ec, thandle)));
+
+  if (ctx->properties_ & YCM_CLIENT)
+    schedule_reconnect(ctx, ec);
 }
 void io_service::register_descriptor(const socket_native_type fd, int flags)
 {
@@ -1087,6 +1641,22 @@ int io_service::write(transport_handle_t transport, std::vector<char> buffer,
     return -1;
   }
 }
+int io_service::write(transport_handle_t transport, chain_obstream&& obs,
+                      std::function<void()> handler)
+{
+  if (transport && transport->is_open())
+  {
+    if (obs.length() > 0)
+      return transport->write_chain(std::move(obs), std::move(handler));
+
+    return 0;
+  }
+  else
+  {
+    YASIO_SLOG("[transport: %p] send failed, the connection not ok!", (void*)transport);
+    return -1;
+  }
+}
 int io_service::write_to(transport_handle_t transport, std::vector<char> buffer,
                          const ip::endpoint& to)
 {
@@ -1131,6 +1701,14 @@ void io_service::do_nonblocking_connect(io_channel* ctx)
   YASIO_SLOG("[index: %d] connecting server %s:%u...", ctx->index_, ctx->remote_host_.c_str(),
              ctx->remote_port_);
 
+  // The attempts can't share the fixed local port
+  if ((ctx->properties_ & YCM_TCP) && ctx->remote_eps_.size() > 1 && ctx->local_port_ == 0 &&
+      options_.connect_attempt_delay_ > 0)
+  {
+    start_connect_attempts(ctx);
+    return;
+  }
+
   if (ctx->socket_->open(ep.af(), ctx->protocol_))
   {
     int ret = 0;
@@ -1173,7 +1751,12 @@ void io_service::do_nonblocking_connect(io_channel* ctx)
     else if (ret == 0)
     { // connect server successful immediately.
       register_descriptor(ctx->socket_->native_handle(), YEM_POLLIN);
-      handle_connect_succeed(ctx, ctx->socket_);
+#if defined(YASIO_HAVE_KCP)
+      if ((ctx->properties_ & (YCM_KCP | YCF_KCP_HANDSHAKE)) == (YCM_KCP | YCF_KCP_HANDSHAKE))
+        do_kcp_handshake(ctx);
+      else
+#endif
+        handle_connect_succeed(ctx, ctx->socket_);
     } // !!!NEVER GO HERE
   }
   else
@@ -1182,17 +1765,32 @@ void io_service::do_nonblocking_connect(io_channel* ctx)
 
 void io_service::do_nonblocking_connect_completion(io_channel* ctx, fd_set* fds_array)
 {
-  assert((ctx->properties_ & YCM_TCP) && (ctx->properties_ & YCM_CLIENT));
+  assert((ctx->properties_ & (YCM_TCP | YCM_KCP)) && (ctx->properties_ & YCM_CLIENT));
   assert(ctx->state_ == io_base::state::OPENING);
 
-  if (ctx->state_ == io_base::state::OPENING)
+#if defined(YASIO_HAVE_KCP)
+  if (ctx->properties_ & YCM_KCP)
   {
-#if !defined(YASIO_HAVE_SSL)
-    int error = -1;
-    if (FD_ISSET(ctx->socket_->native_handle(), &fds_array[write_op]) ||
-        FD_ISSET(ctx->socket_->native_handle(), &fds_array[read_op]))
-    {
-      socklen_t len = sizeof(error);
+    do_kcp_handshake_completion(ctx, fds_array);
+    return;
+  }
+#endif
+  if (!ctx->connect_attempts_.empty())
+  {
+    do_connect_attempts_completion(ctx, fds_array);
+    return;
+  }
+
+  if (ctx->state_ == io_base::state::OPENING)
+  {
+#if !defined(YASIO_HAVE_SSL)
+    int error = -1;
+    if (FD_ISSET(ctx->socket_->native_handle(), &fds_array[write_op]) ||
+        FD_ISSET(ctx->socket_->native_handle(), &fds_array[read_op]))
+    {
+      ctx->timer_.cancel(); // cancel before handle_connect_failed, which may start reconnect
+
+      socklen_t len = sizeof(error);
       if (::getsockopt(ctx->socket_->native_handle(), SOL_SOCKET, SO_ERROR, (char*)&error, &len) >=
               0 &&
           error == 0)
@@ -1203,8 +1801,6 @@ void io_service::do_nonblocking_connect_completion(io_channel* ctx, fd_set* fds_
       }
       else
         handle_connect_failed(ctx, error);
-
-      ctx->timer_.cancel();
     }
 #else
     if ((ctx->properties_ & YCPF_SSL_HANDSHAKING) == 0)
@@ -1232,11 +1828,131 @@ void io_service::do_nonblocking_connect_completion(io_channel* ctx, fd_set* fds_
     else
       do_ssl_handshake(ctx);
 
-    if (ctx->state_ != io_base::state::OPENING)
+    // the failed already canceled, and maybe waiting to reconnect
+    if (ctx->state_ == io_base::state::OPEN)
       ctx->timer_.cancel();
 #endif
   }
 }
+void io_service::start_connect_attempts(io_channel* ctx)
+{
+  ctx->next_attempt_ = 0;
+  int error          = do_connect_attempt(ctx);
+  if (error != 0)
+  {
+    handle_connect_failed(ctx, error);
+    return;
+  }
+
+  // Starts next attempt every delay until one established, the deadline covers ssl handshake
+  ctx->set_last_errno(EINPROGRESS);
+  auto deadline = highp_clock() + options_.connect_timeout_;
+  ctx->timer_.expires_from_now(std::chrono::microseconds(options_.connect_attempt_delay_));
+  ctx->timer_.async_wait([this, ctx, deadline]() {
+    if (ctx->state_ != io_base::state::OPENING)
+      return true;
+    if (highp_clock() >= deadline)
+    {
+      handle_connect_failed(ctx, ETIMEDOUT);
+      return true;
+    }
+    if (!ctx->connect_attempts_.empty() && !(ctx->opmask_ & YOPM_CLOSE_TRANSPORT))
+      do_connect_attempt(ctx);
+    return false;
+  });
+}
+int io_service::do_connect_attempt(io_channel* ctx)
+{
+  int error = YERR_NO_AVAIL_ADDR;
+  while (ctx->next_attempt_ < ctx->remote_eps_.size())
+  {
+    auto& ep = ctx->remote_eps_[ctx->next_attempt_++];
+    auto s   = std::make_shared<xxsocket>();
+    if (s->open(ep.af(), ctx->protocol_))
+    {
+      if (ctx->properties_ & YCF_REUSEADDR)
+        s->reuse_address(true);
+      if (ctx->properties_ & YCF_EXCLUSIVEADDRUSE)
+        s->reuse_address(false);
+      if (xxsocket::connect_n(s->native_handle(), ep) == 0 ||
+          (error = xxsocket::get_last_errno()) == EINPROGRESS || error == EWOULDBLOCK)
+      { // The established one is reported by select too
+        register_descriptor(s->native_handle(), YEM_POLLIN | YEM_POLLOUT);
+        ctx->connect_attempts_.push_back(std::move(s));
+        return 0;
+      }
+    }
+    else
+      error = xxsocket::get_last_errno();
+    YASIO_SLOGV("[index: %d] connect %s failed, ec=%d", ctx->index_, ep.to_string().c_str(),
+                error);
+  }
+  return error;
+}
+void io_service::do_connect_attempts_completion(io_channel* ctx, fd_set* fds_array)
+{
+  if (ctx->opmask_ & YOPM_CLOSE_TRANSPORT)
+  {
+    ctx->timer_.cancel();
+    handle_connect_failed(ctx, YERR_LOCAL_SHUTDOWN);
+    return;
+  }
+
+  int error = 0, failed = 0;
+  for (auto it = ctx->connect_attempts_.begin(); it != ctx->connect_attempts_.end();)
+  {
+    auto fd = (*it)->native_handle();
+    if (!FD_ISSET(fd, &fds_array[write_op]) && !FD_ISSET(fd, &fds_array[read_op]))
+    {
+      ++it;
+      continue;
+    }
+    socklen_t len = sizeof(error);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, (char*)&error, &len) >= 0 && error == 0)
+    { // The first established wins, cancel the others
+      ctx->socket_ = std::move(*it);
+      ctx->connect_attempts_.erase(it);
+      close_connect_attempts(ctx);
+      unregister_descriptor(fd, YEM_POLLOUT);
+#if defined(YASIO_HAVE_SSL)
+      if (ctx->properties_ & YCM_SSL)
+        do_ssl_handshake(ctx);
+      else
+#endif
+        handle_connect_succeed(ctx, ctx->socket_);
+      if (ctx->state_ == io_base::state::OPEN)
+        ctx->timer_.cancel();
+      return;
+    }
+    unregister_descriptor(fd, YEM_POLLIN | YEM_POLLOUT);
+    (*it)->close();
+    it = ctx->connect_attempts_.erase(it);
+    ++failed;
+  }
+
+  // Don't wait the delay when an attempt failed, see RFC 8305 section 5
+  while (failed-- > 0)
+  {
+    int ec = do_connect_attempt(ctx);
+    if (ec == YERR_NO_AVAIL_ADDR)
+      break;
+    error = ec;
+  }
+  if (ctx->connect_attempts_.empty())
+  {
+    ctx->timer_.cancel();
+    handle_connect_failed(ctx, error);
+  }
+}
+void io_service::close_connect_attempts(io_channel* ctx)
+{
+  for (auto& s : ctx->connect_attempts_)
+  {
+    unregister_descriptor(s->native_handle(), YEM_POLLIN | YEM_POLLOUT);
+    s->close();
+  }
+  ctx->connect_attempts_.clear();
+}
 #if defined(YASIO_HAVE_SSL)
 void io_service::init_ssl_context()
 {
@@ -1249,6 +1965,38 @@ void io_service::init_ssl_context()
       YASIO_LOG("load ca certifaction file failed!");
   }
   SSL_CTX_set_mode(ssl_ctx_, SSL_MODE_ENABLE_PARTIAL_WRITE);
+#if defined(SSL_OP_ENABLE_KTLS)
+  if (this->options_.ssl_ktls_)
+    SSL_CTX_set_options(ssl_ctx_, SSL_OP_ENABLE_KTLS);
+#endif
+
+  if (this->options_.ssl_session_cache_)
+  { // The TLS 1.3 tickets are sent after handshake, so only the new session callback can get them
+    SSL_CTX_set_session_cache_mode(ssl_ctx_,
+                                   SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    ::SSL_CTX_sess_set_new_cb(ssl_ctx_, &io_service::ssl_new_session_cb);
+  }
+
+  if (!this->options_.certfile_.empty())
+  {
+    ssl_server_ctx_ = ::SSL_CTX_new(SSLv23_server_method());
+    if (::SSL_CTX_use_certificate_chain_file(ssl_server_ctx_, options_.certfile_.c_str()) != 1 ||
+        ::SSL_CTX_use_PrivateKey_file(ssl_server_ctx_, options_.keyfile_.c_str(),
+                                      SSL_FILETYPE_PEM) != 1)
+    {
+      YASIO_LOG("load ssl server certificate or private key file failed!");
+      ::SSL_CTX_free(ssl_server_ctx_);
+      ssl_server_ctx_ = nullptr;
+    }
+    else
+    {
+      SSL_CTX_set_mode(ssl_server_ctx_, SSL_MODE_ENABLE_PARTIAL_WRITE);
+#if defined(SSL_OP_ENABLE_KTLS)
+      if (this->options_.ssl_ktls_)
+        SSL_CTX_set_options(ssl_server_ctx_, SSL_OP_ENABLE_KTLS);
+#endif
+    }
+  }
 }
 SSL_CTX* io_service::get_ssl_context() { return ssl_ctx_; }
 void io_service::cleanup_ssl_context()
@@ -1258,6 +2006,36 @@ void io_service::cleanup_ssl_context()
     SSL_CTX_free((SSL_CTX*)ssl_ctx_);
     ssl_ctx_ = nullptr;
   }
+  if (ssl_server_ctx_)
+  {
+    SSL_CTX_free(ssl_server_ctx_);
+    ssl_server_ctx_ = nullptr;
+  }
+  clear_ssl_sessions();
+}
+int io_service::ssl_new_session_cb(SSL* ssl, SSL_SESSION* session)
+{
+  auto ctx = static_cast<io_channel*>(SSL_get_app_data(ssl));
+  if (!ctx)
+    return 0;
+  auto& cached = ctx->get_service().ssl_cached_session(ctx);
+  if (cached)
+    ::SSL_SESSION_free(cached);
+  cached = session;
+  return 1; // take the ownership of session
+}
+SSL_SESSION*& io_service::ssl_cached_session(io_channel* ctx)
+{
+  char suffix[sizeof ":65535"];
+  snprintf(suffix, sizeof(suffix), ":%u", ctx->remote_port_);
+  return this->ssl_sessions_[ctx->remote_host_ + suffix];
+}
+void io_service::clear_ssl_sessions()
+{
+  for (auto& item : ssl_sessions_)
+    if (item.second)
+      ::SSL_SESSION_free(item.second);
+  ssl_sessions_.clear();
 }
 void io_service::do_ssl_handshake(io_channel* ctx)
 {
@@ -1266,6 +2044,13 @@ void io_service::do_ssl_handshake(io_channel* ctx)
     auto ssl = ::SSL_new(get_ssl_context());
     ::SSL_set_fd(ssl, ctx->socket_->native_handle());
     ::SSL_set_connect_state(ssl);
+    SSL_set_app_data(ssl, ctx);
+    if (this->options_.ssl_session_cache_)
+    {
+      auto session = ssl_cached_session(ctx);
+      if (session)
+        ::SSL_set_session(ssl, session);
+    }
     ctx->properties_ |= YCPF_SSL_HANDSHAKING; // start ssl handshake
     ctx->ssl_.reset(ssl);
   }
@@ -1285,6 +2070,15 @@ void io_service::do_ssl_handshake(io_channel* ctx)
       YASIO_LOG("SSL_do_handshake fail with ret=%d,error=%d, errno=%d, detail:%s\n", ret, error,
                 errno, strerror(errno));
 
+      if (this->options_.ssl_session_cache_)
+      { // the session maybe rejected, don't resume it again
+        auto& cached = ssl_cached_session(ctx);
+        if (cached)
+        {
+          ::SSL_SESSION_free(cached);
+          cached = nullptr;
+        }
+      }
       ctx->ssl_.destroy();
       handle_connect_failed(ctx, YERR_SSL_HANDSHAKE_FAILED);
     }
@@ -1292,16 +2086,185 @@ void io_service::do_ssl_handshake(io_channel* ctx)
   else
     handle_connect_succeed(ctx, ctx->socket_);
 }
+void io_service::do_ssl_accept(io_channel* ctx, std::shared_ptr<xxsocket> socket)
+{
+  if (!ssl_server_ctx_)
+  {
+    YASIO_SLOG("[index: %d] the ssl server certificate not set, see YOPT_S_SSL_CERT", ctx->index_);
+    return; // the socket closed by xxsocket destructor
+  }
+
+  socket->set_nonblocking(true);
+  auto ssl = ::SSL_new(ssl_server_ctx_);
+  ::SSL_set_fd(ssl, static_cast<int>(socket->native_handle()));
+  ::SSL_set_accept_state(ssl);
+  register_descriptor(socket->native_handle(), YEM_POLLIN);
+
+  io_channel::ssl_accept accept;
+  accept.socket      = std::move(socket);
+  accept.expire_time = highp_clock() + options_.connect_timeout_;
+  accept.ssl.reset(ssl);
+  ctx->ssl_accepts_.push_back(std::move(accept));
+
+  // Arm the timer, the stalled client may never wakeup the event loop to check it
+  if (ctx->ssl_accepts_deadline_ == 0)
+    do_ssl_accept_completion(ctx, nullptr);
+}
+void io_service::do_ssl_accept_completion(io_channel* ctx, fd_set* fds_array)
+{
+  auto now      = highp_clock();
+  auto earliest = (std::numeric_limits<highp_time_t>::max)();
+  for (auto iter = ctx->ssl_accepts_.begin(); iter != ctx->ssl_accepts_.end();)
+  {
+    auto& accept = *iter;
+    if (accept.busy)
+    { // the worker owns the ssl now
+      ++iter;
+      continue;
+    }
+
+    bool handshaking = true;
+    auto fd          = accept.socket->native_handle();
+    if (fds_array && (FD_ISSET(fd, &fds_array[read_op]) || FD_ISSET(fd, &fds_array[write_op])))
+    {
+      if (options_.ssl_handshake_threads_ > 0)
+      { // don't watch the socket until the step done
+        unregister_descriptor(fd, YEM_POLLIN | YEM_POLLOUT);
+        accept.busy = true;
+        SSL* ssl    = accept.ssl;
+        ssl_pool_.run_task([=] {
+          int result = yasio__ssl_handshake(ssl);
+          std::lock_guard<std::mutex> lck(ssl_completions_mtx_);
+          ssl_completions_.push_back(ssl_completion{ctx, ssl, result});
+          this->interrupt();
+        });
+        ++iter;
+        continue;
+      }
+      handshaking = handle_ssl_accept_step(ctx, accept, yasio__ssl_handshake(accept.ssl));
+    }
+    if (handshaking && now >= accept.expire_time)
+    {
+      YASIO_SLOGV("[index: %d] the ssl handshake timeout", ctx->index_);
+      unregister_descriptor(fd, YEM_POLLIN | YEM_POLLOUT);
+      handshaking = false;
+    }
+    if (handshaking)
+    {
+      earliest = (std::min)(earliest, accept.expire_time);
+      ++iter;
+      continue;
+    }
+
+    // The handshake not completed never be reported to user, so just drop it.
+    auto socket      = std::move(accept.socket);
+    bool established = (accept.ssl == nullptr); // the ssl moved to channel
+    iter             = ctx->ssl_accepts_.erase(iter);
+    if (established)
+      handle_connect_succeed(ctx, std::move(socket));
+  }
+
+  // The timer wakeup the event loop to drop the expired handshakes
+  if (earliest == (std::numeric_limits<highp_time_t>::max)())
+  {
+    if (ctx->ssl_accepts_deadline_ != 0)
+    {
+      ctx->ssl_accepts_deadline_ = 0;
+      ctx->timer_.cancel();
+    }
+  }
+  else if (ctx->ssl_accepts_deadline_ != earliest)
+  {
+    ctx->ssl_accepts_deadline_ = earliest;
+    ctx->timer_.cancel();
+    ctx->timer_.expires_from_now(std::chrono::microseconds((std::max)(earliest - now, 0LL)));
+    ctx->timer_.async_wait_once([this, ctx]() {
+      ctx->ssl_accepts_deadline_ = 0;
+      do_ssl_accept_completion(ctx, nullptr);
+    });
+  }
+}
+bool io_service::handle_ssl_accept_step(io_channel* ctx, io_channel::ssl_accept& accept,
+                                        int result)
+{
+  auto fd = accept.socket->native_handle();
+  switch (result)
+  {
+    case YSSL_HANDSHAKE_WANT_READ:
+      unregister_descriptor(fd, YEM_POLLOUT);
+      register_descriptor(fd, YEM_POLLIN);
+      return true;
+    case YSSL_HANDSHAKE_WANT_WRITE:
+      register_descriptor(fd, YEM_POLLIN | YEM_POLLOUT);
+      return true;
+    case YSSL_HANDSHAKE_OK:
+      ctx->ssl_ = std::move(accept.ssl); // moved to the transport
+      break;
+    default:
+      YASIO_SLOGV("[index: %d] the ssl handshake failed", ctx->index_);
+  }
+  unregister_descriptor(fd, YEM_POLLIN | YEM_POLLOUT);
+  return false;
+}
+void io_service::close_ssl_accepts(io_channel* ctx)
+{
+  for (auto iter = ctx->ssl_accepts_.begin(); iter != ctx->ssl_accepts_.end();)
+  {
+    unregister_descriptor(iter->socket->native_handle(), YEM_POLLIN | YEM_POLLOUT);
+    if (iter->busy)
+    { // free it after the worker done, see process_ssl_completions
+      iter->dropped = true;
+      ++iter;
+    }
+    else
+      iter = ctx->ssl_accepts_.erase(iter);
+  }
+  if (ctx->ssl_accepts_deadline_ != 0)
+  {
+    ctx->ssl_accepts_deadline_ = 0;
+    ctx->timer_.cancel();
+  }
+}
+void io_service::process_ssl_completions()
+{
+  std::vector<ssl_completion> completions;
+  {
+    std::lock_guard<std::mutex> lck(ssl_completions_mtx_);
+    if (ssl_completions_.empty())
+      return;
+    completions.swap(ssl_completions_);
+  }
+  for (auto& completion : completions)
+  {
+    auto ctx  = completion.ctx;
+    auto iter = std::find_if(
+        ctx->ssl_accepts_.begin(), ctx->ssl_accepts_.end(),
+        [&](io_channel::ssl_accept& accept) { return accept.ssl == completion.ssl; });
+    if (iter == ctx->ssl_accepts_.end())
+      continue;
+    iter->busy = false;
+    if (iter->dropped || !handle_ssl_accept_step(ctx, *iter, completion.result))
+    {
+      auto socket      = std::move(iter->socket);
+      bool established = !iter->dropped && iter->ssl == nullptr;
+      ctx->ssl_accepts_.erase(iter);
+      if (established)
+        handle_connect_succeed(ctx, std::move(socket));
+    }
+    // Check timeout & rearm the timer
+    do_ssl_accept_completion(ctx, nullptr);
+  }
+}
 #endif
 #if defined(YASIO_HAVE_CARES)
 void io_service::ares_getaddrinfo_cb(void* arg, int status, int timeouts, ares_addrinfo* answerlist)
 {
-  auto ctx              = (io_channel*)arg;
-  auto& current_service = ctx->get_service();
+  auto record           = (dns_record*)arg;
+  auto& current_service = *record->service_;
 
-  ctx->timer_.cancel();
   current_service.ares_work_finished();
 
+  highp_time_t ttl = 0;
   if (status == ARES_SUCCESS)
   {
     if (answerlist != nullptr)
@@ -1309,35 +2272,31 @@ void io_service::ares_getaddrinfo_cb(void* arg, int status, int timeouts, ares_a
       for (auto ai = answerlist->nodes; ai != nullptr; ai = ai->ai_next)
       {
         if (ai->ai_family == AF_INET6 || ai->ai_family == AF_INET)
-        {
-          ctx->remote_eps_.push_back(ip::endpoint(ai->ai_addr));
-          break;
+        { // the record expires with the shortest ttl
+          record->endpoints_.push_back(ip::endpoint(ai->ai_addr));
+          auto ai_ttl = static_cast<highp_time_t>(ai->ai_ttl) * std::micro::den;
+          if (ai_ttl > 0 && (ttl == 0 || ai_ttl < ttl))
+            ttl = ai_ttl;
         }
       }
     }
   }
 
-  if (!ctx->remote_eps_.empty())
+  if (!record->endpoints_.empty())
   {
-    ctx->dns_queries_state_     = YDQS_READY;
-    ctx->dns_queries_timestamp_ = highp_clock();
 #  if defined(YASIO_ENABLE_ARES_PROFILER)
     YASIO_SLOG_IMPL(current_service.options_,
-                    "[index: %d] ares_getaddrinfo_cb: resolve %s succeed, cost:%g(ms)", ctx->index_,
-                    ctx->remote_host_.c_str(),
-                    (ctx->dns_queries_timestamp_ - ctx->ares_start_time_) / 1000.0);
+                    "ares_getaddrinfo_cb: resolve %s succeed, ttl:%ds, cost:%g(ms)",
+                    record->host_.c_str(), static_cast<int>(ttl / std::micro::den),
+                    (highp_clock() - record->start_time_) / 1000.0);
 #  endif
   }
   else
-  {
-    ctx->set_last_errno(YERR_RESOLV_HOST_FAILED);
-    YDQS_SET_STATE(ctx->dns_queries_state_, YDQS_FAILED);
     YASIO_SLOG_IMPL(current_service.options_,
-                    "[index: %d] ares_getaddrinfo_cb: resolve %s failed, status=%d, detail:%s",
-                    ctx->index_, ctx->remote_host_.c_str(), status, ::ares_strerror(status));
-  }
+                    "ares_getaddrinfo_cb: resolve %s failed, status=%d, detail:%s",
+                    record->host_.c_str(), status, ::ares_strerror(status));
 
-  current_service.interrupt();
+  current_service.complete_resolve(record, ttl);
 }
 void io_service::process_ares_requests(fd_set* fds_array)
 {
@@ -1409,6 +2368,12 @@ void io_service::cleanup_ares_channel()
 #endif
 void io_service::do_nonblocking_accept(io_channel* ctx)
 { // channel is server
+#if defined(YASIO_HAVE_KCP)
+  close_kcp_sessions(ctx);
+#endif
+#if defined(YASIO_HAVE_SSL)
+  close_ssl_accepts(ctx);
+#endif
   cleanup_io(ctx);
 
   // server: don't need resolve, don't use remote_eps_
@@ -1460,6 +2425,10 @@ void io_service::do_nonblocking_accept_completion(io_channel* ctx, fd_set* fds_a
 {
   if (ctx->state_ == io_base::state::OPEN)
   {
+#if defined(YASIO_HAVE_SSL)
+    if (!ctx->ssl_accepts_.empty())
+      do_ssl_accept_completion(ctx, fds_array);
+#endif
     int error = -1;
     if (FD_ISSET(ctx->socket_->native_handle(), &fds_array[read_op]))
     {
@@ -1473,11 +2442,22 @@ void io_service::do_nonblocking_accept_completion(io_channel* ctx, fd_set* fds_a
           socket_native_type sockfd;
           error = ctx->socket_->accept_n(sockfd);
           if (error == 0)
-            handle_connect_succeed(ctx, std::make_shared<xxsocket>(sockfd));
+          {
+#if defined(YASIO_HAVE_SSL)
+            if (ctx->properties_ & YCM_SSL)
+              do_ssl_accept(ctx, std::make_shared<xxsocket>(sockfd));
+            else
+#endif
+              handle_connect_succeed(ctx, std::make_shared<xxsocket>(sockfd));
+          }
           else // The non blocking tcp accept failed can be ignored.
             YASIO_SLOGV("[index: %d] socket.fd=%d, accept failed, ec=%u", ctx->index(),
                         (int)ctx->socket_->native_handle(), error);
         }
+#if defined(YASIO_HAVE_KCP)
+        else if (ctx->properties_ & YCM_KCP)
+          do_kcp_accept_completion(ctx, fds_array);
+#endif
         else // YCM_UDP
         {
           ip::endpoint peer;
@@ -1497,6 +2477,10 @@ void io_service::do_nonblocking_accept_completion(io_channel* ctx, fd_set* fds_a
             auto transport =
                 it != this->dgram_clients_.end() ? it->second : do_dgram_accept(ctx, peer);
 #endif
+            if (transport && (ctx->properties_ & YCF_PMTUD) &&
+                static_cast<io_transport_udp*>(transport)->handle_pmtu_packet(
+                    &ctx->buffer_.front(), n))
+              transport = nullptr; // the probe packet is consumed
             if (transport)
             {
               this->handle_event(event_ptr(new io_event(
@@ -1553,6 +2537,250 @@ transport_handle_t io_service::do_dgram_accept(io_channel* ctx, const ip::endpoi
 
   return nullptr;
 }
+#if defined(YASIO_HAVE_KCP)
+void io_service::do_kcp_accept_completion(io_channel* ctx, fd_set* fds_array)
+{
+  ip::endpoint peer;
+  auto buf = &ctx->buffer_.front();
+  for (int i = 0; i < YASIO_KCP_MAX_DEMUX; ++i)
+  {
+    int n = ctx->socket_->recvfrom(buf, static_cast<int>(ctx->buffer_.size()), peer);
+    if (n <= 0)
+    {
+      int error = xxsocket::get_last_errno();
+      if (SHOULD_CLOSE_0(n, error))
+      {
+        YASIO_SLOG("[index: %d] recvfrom failed, ec=%d", ctx->index_, error);
+        close(ctx->index_);
+      }
+      break;
+    }
+
+    auto peer_it = ctx->kcp_peers_.find(peer);
+    auto session = peer_it != ctx->kcp_peers_.end() ? peer_it->second : nullptr;
+    if (ctx->properties_ & YCF_PMTUD)
+    {
+      int size;
+      auto magic = yasio__pmtu_decode(buf, n, size);
+      if (magic == YPMTU_PROBE_MAGIC) // reply the source address, the client maybe rebinding
+        ctx->socket_->sendto(buf, yasio__pmtu_encode(buf, YPMTU_ACK_MAGIC, size), peer);
+      else if (magic == YPMTU_ACK_MAGIC && session)
+        session->handle_pmtu_packet(buf, n);
+      if (magic != 0)
+        continue;
+    }
+    if (n < YKCP_OVERHEAD)
+    { // handshake request, assign a conv for the client
+      uint32_t nonce, conv;
+      if (!yasio__kcp_handshake_decode(buf, n, nonce, conv) || conv != 0)
+        continue;
+      // always reply, the previous SYN-ACK may lost
+      conv = (session && session->nonce_ == nonce) ? session->kcp_->conv
+                                                   : do_kcp_handshake_accept(ctx, peer, nonce);
+      if (conv != 0)
+        ctx->socket_->sendto(buf, yasio__kcp_handshake_encode(buf, nonce, conv), peer);
+      continue;
+    }
+
+    // With fec, the kcp segment is the payload of data shard, the parity shards are demuxed by
+    // endpoint only
+    const char* segment = buf;
+    int size            = n;
+    if (ctx->kcp_.fec_parity > 0)
+      segment = fec_shard::payload(buf, n, size);
+
+    bool accepted = false;
+    if (segment && size >= YKCP_OVERHEAD)
+    {
+      auto conv = ::ikcp_getconv(segment);
+      auto it   = conv != 0 ? ctx->kcp_sessions_.find(conv) : ctx->kcp_sessions_.end();
+      if (it != ctx->kcp_sessions_.end())
+        session = it->second;
+      else if (conv != 0 || !session)
+      { // the conv maybe assigned by client self(see YOPT_C_KCP_CONV), or 0 without handshake
+        session  = do_kcp_accept(ctx, peer, conv, buf, n);
+        accepted = true;
+      }
+    }
+    if (!session)
+      continue;
+
+    bool rebinding = session->peer_ < peer || peer < session->peer_;
+    if (!accepted)
+    {
+      // Anyone can send datagrams with a guessed conv, the client at a new address must prove
+      // it's the sender of the stream by the data segment kcp waits for
+      uint32_t rcv_nxt = session->kcp_->rcv_nxt;
+      if (rebinding && !(segment && yasio__kcp_has_next_push(segment, size, rcv_nxt)))
+        continue;
+      // Don't close the session for malformed datagrams, anyone can send them to the server
+      if (session->kcp_input(buf, n) != 0)
+        continue;
+      session->active_time_ = highp_clock();
+      rebinding             = rebinding && session->kcp_->rcv_nxt != rcv_nxt;
+    }
+
+    if (rebinding)
+    { // NAT rebinding, the client address changed, the conv identify it
+      YASIO_SLOG("[index: %d] the connection #%u [%s] rebinding to [%s]", ctx->index_,
+                 session->id_, session->peer_.to_string().c_str(), peer.to_string().c_str());
+      auto old_it = ctx->kcp_peers_.find(session->peer_);
+      if (old_it != ctx->kcp_peers_.end() && old_it->second == session)
+        ctx->kcp_peers_.erase(old_it);
+      ctx->kcp_peers_[peer] = session;
+      session->peer_        = peer;
+    }
+
+    // Deliver the messages now, otherwise they have to wait the next event loop
+    long long max_wait_duration = 0;
+    size                        = ::ikcp_peeksize(session->kcp_);
+    while (size > 0 && size <= static_cast<int>(sizeof(session->buffer_)) - session->wpos_)
+    {
+      if (!do_read(session, fds_array, max_wait_duration))
+      {
+        close(session);
+        break;
+      }
+      size = ::ikcp_peeksize(session->kcp_);
+    }
+  }
+}
+uint32_t io_service::do_kcp_handshake_accept(io_channel* ctx, const ip::endpoint& peer,
+                                             uint32_t nonce)
+{
+  auto& handshakes = ctx->kcp_handshakes_;
+  auto now         = highp_clock();
+  auto it          = handshakes.find(peer);
+  if (it != handshakes.end() && it->second.nonce == nonce)
+  { // the SYN retransmitted
+    it->second.expire_time = now + options_.connect_timeout_;
+    return it->second.conv;
+  }
+  if (it == handshakes.end() && handshakes.size() >= YASIO_KCP_MAX_HANDSHAKES)
+  {
+    for (auto purge_it = handshakes.begin(); purge_it != handshakes.end();)
+    {
+      if (purge_it->second.expire_time < now)
+        purge_it = handshakes.erase(purge_it);
+      else
+        ++purge_it;
+    }
+    if (handshakes.size() >= YASIO_KCP_MAX_HANDSHAKES)
+      return 0;
+  }
+
+  // The conv is random, so the off-path attackers can't guess the conv of other sessions
+  uint32_t conv;
+  do
+    conv = yasio__kcp_random_conv();
+  while (conv == 0 || ctx->kcp_sessions_.find(conv) != ctx->kcp_sessions_.end());
+  handshakes[peer] = io_channel::kcp_handshake{conv, nonce, now + options_.connect_timeout_};
+  return conv;
+}
+io_transport_kcp* io_service::do_kcp_accept(io_channel* ctx, const ip::endpoint& peer,
+                                            uint32_t conv, const char* data, int len)
+{
+  auto hs_it      = ctx->kcp_handshakes_.find(peer);
+  bool handshaked = conv != 0 && hs_it != ctx->kcp_handshakes_.end() && hs_it->second.conv == conv;
+  auto peer_it    = ctx->kcp_peers_.find(peer);
+  if (!handshaked && peer_it != ctx->kcp_peers_.end())
+    return nullptr; // only the handshake can replace the session of the address
+
+  auto transport        = static_cast<io_transport_kcp*>(allocate_transport(ctx, ctx->socket_));
+  transport->kcp_->conv = conv;
+  transport->confgure_remote(peer, false);
+  // The session is announced only when kcp accepts the first datagram, without handshake, it
+  // must be the data segment kcp waits for, otherwise any datagram creates a session
+  if (transport->kcp_input(data, len) != 0 || (!handshaked && transport->kcp_->rcv_nxt == 0))
+  {
+    deallocate_transport(transport);
+    return nullptr;
+  }
+  if (handshaked)
+  {
+    transport->nonce_ = hs_it->second.nonce;
+    ctx->kcp_handshakes_.erase(hs_it);
+    if (peer_it != ctx->kcp_peers_.end()) // the client restarted with the same address
+      close(peer_it->second);
+  }
+
+  transport->active_time_ = highp_clock();
+  if (conv != 0)
+    ctx->kcp_sessions_[conv] = transport;
+  ctx->kcp_peers_[peer] = transport;
+  handle_connect_succeed(transport);
+  return transport;
+}
+void io_service::close_kcp_sessions(io_channel* ctx)
+{
+  ctx->kcp_handshakes_.clear();
+  for (auto& item : ctx->kcp_peers_)
+    item.second->opmask_ |= YOPM_CLOSE_TRANSPORT;
+  for (auto& item : ctx->kcp_sessions_)
+    item.second->opmask_ |= YOPM_CLOSE_TRANSPORT;
+  ctx->kcp_peers_.clear();
+  ctx->kcp_sessions_.clear();
+}
+void io_service::unbind_kcp_session(io_transport_kcp* session)
+{
+  auto ctx = session->ctx_;
+  auto it  = ctx->kcp_sessions_.find(session->kcp_->conv);
+  if (it != ctx->kcp_sessions_.end() && it->second == session)
+    ctx->kcp_sessions_.erase(it);
+  auto peer_it = ctx->kcp_peers_.find(session->peer_);
+  if (peer_it != ctx->kcp_peers_.end() && peer_it->second == session)
+    ctx->kcp_peers_.erase(peer_it);
+  // The listening socket is shared by all sessions, it's closed by channel
+  session->socket_.reset();
+}
+void io_service::do_kcp_handshake(io_channel* ctx)
+{
+  ctx->set_last_errno(EINPROGRESS);
+  ctx->kcp_.nonce = static_cast<uint32_t>(xhighp_clock()) | 1;
+
+  char buf[YKCP_SYN_SIZE];
+  int n = yasio__kcp_handshake_encode(buf, ctx->kcp_.nonce, 0);
+  ctx->socket_->sendto(buf, n, ctx->remote_eps_[0]);
+
+  // Resend the SYN until the SYN-ACK received or connect timeout
+  auto deadline = highp_clock() + options_.connect_timeout_;
+  ctx->timer_.expires_from_now(std::chrono::milliseconds(YASIO_KCP_SYN_INTERVAL));
+  ctx->timer_.async_wait([this, ctx, deadline]() {
+    if (ctx->state_ != io_base::state::OPENING)
+      return true;
+    if (highp_clock() >= deadline)
+    {
+      handle_connect_failed(ctx, ETIMEDOUT);
+      return true;
+    }
+    char buf[YKCP_SYN_SIZE];
+    int n = yasio__kcp_handshake_encode(buf, ctx->kcp_.nonce, 0);
+    ctx->socket_->sendto(buf, n, ctx->remote_eps_[0]);
+    return false;
+  });
+}
+void io_service::do_kcp_handshake_completion(io_channel* ctx, fd_set* fds_array)
+{
+  if (!FD_ISSET(ctx->socket_->native_handle(), &fds_array[read_op]))
+    return;
+
+  ip::endpoint peer;
+  char buf[YKCP_OVERHEAD];
+  uint32_t nonce, conv;
+  int n;
+  // The datagrams before SYN-ACK are discarded, kcp will retransmit them
+  while ((n = ctx->socket_->recvfrom(buf, sizeof(buf), peer)) > 0)
+  {
+    if (yasio__kcp_handshake_decode(buf, n, nonce, conv) && conv != 0 && nonce == ctx->kcp_.nonce)
+    {
+      ctx->timer_.cancel();
+      ctx->kcp_.conv = conv;
+      handle_connect_succeed(ctx, ctx->socket_);
+      break;
+    }
+  }
+}
+#endif
 void io_service::handle_connect_succeed(transport_handle_t transport)
 {
   this->transports_.push_back(transport);
@@ -1560,7 +2788,10 @@ void io_service::handle_connect_succeed(transport_handle_t transport)
   ctx->set_last_errno(0); // clear errno, value may be EINPROGRESS
   auto& connection = transport->socket_;
   if (ctx->properties_ & YCM_CLIENT)
-    ctx->state_ = io_base::state::OPEN;
+  {
+    ctx->state_              = io_base::state::OPEN;
+    ctx->reconnect_.attempts = 0;
+  }
   else
   { // tcp/udp server, accept a new client session
     connection->set_nonblocking(true);
@@ -1577,6 +2808,8 @@ void io_service::handle_connect_succeed(transport_handle_t transport)
       connection->set_keepalive(options_.tcp_keepalive_.onoff, options_.tcp_keepalive_.idle,
                                 options_.tcp_keepalive_.interval, options_.tcp_keepalive_.probs);
   }
+  else if (ctx->properties_ & YCF_PMTUD) // udp/kcp, wakeup the event loop to start probing
+    this->interrupt();
 
   notify_connect_succeed(transport);
 }
@@ -1634,11 +2867,48 @@ void io_service::handle_connect_failed(io_channel* ctx, int error)
   ctx->properties_ &= ~YCPF_SSL_HANDSHAKING;
 #endif
 
+  close_connect_attempts(ctx);
   cleanup_io(ctx);
 
   YASIO_SLOG("[index: %d] connect server %s:%u failed, ec=%d, detail:%s", ctx->index_,
              ctx->remote_host_.c_str(), ctx->remote_port_, error, io_service::strerror(error));
   this->handle_event(event_ptr(new io_event(ctx->index_, YEK_CONNECT_RESPONSE, error, nullptr)));
+
+  schedule_reconnect(ctx, error);
+}
+void io_service::schedule_reconnect(io_channel* ctx, int error)
+{
+  auto& policy = ctx->reconnect_;
+  if (policy.initial_delay <= 0 || error == YERR_LOCAL_SHUTDOWN)
+    return;
+  if (policy.max_attempts > 0 && policy.attempts >= policy.max_attempts)
+  {
+    YASIO_SLOG("[index: %d] give up reconnect after %d attempts", ctx->index_, policy.attempts);
+    return;
+  }
+
+  highp_time_t delay = policy.initial_delay;
+  for (int i = 0; i < policy.attempts && delay < policy.max_delay; ++i)
+    delay *= policy.multiplier;
+  delay = (std::min)(delay, (highp_time_t)policy.max_delay) * std::milli::den;
+  if (policy.jitter > 0)
+  { // spread the clients lost at same time, the clock is random enough at nanoseconds
+    auto span = delay / 100 * policy.jitter;
+    auto seed = static_cast<uint64_t>(xhighp_clock() + ctx->index_);
+    delay += static_cast<highp_time_t>(yasio__mix64(seed) % (2 * span + 1)) - span;
+  }
+  ++policy.attempts;
+
+  YASIO_SLOG("[index: %d] reconnect after %lldms, attempt: %d", ctx->index_,
+             delay / std::milli::den, policy.attempts);
+  ctx->properties_ |= YCPF_RECONNECTING;
+  ctx->timer_.cancel();
+  ctx->timer_.expires_from_now(std::chrono::microseconds(delay));
+  ctx->timer_.async_wait_once([this, ctx]() {
+    ctx->properties_ &= ~YCPF_RECONNECTING;
+    if (ctx->state_ == io_base::state::CLOSED && !(ctx->opmask_ & YOPM_OPEN_CHANNEL))
+      open_internal(ctx);
+  });
 }
 bool io_service::do_read(transport_handle_t transport, fd_set* fds_array,
                          long long& max_wait_duration)
@@ -1677,7 +2947,9 @@ bool io_service::do_read(transport_handle_t transport, fd_set* fds_array,
 #endif
       if (transport->expected_size_ == -1)
       { // decode length
-        int length = transport->ctx_->decode_len_(transport->buffer_, transport->wpos_ + n);
+        int length = transport->ctx_->dbf_.delimiter_length > 0
+                         ? transport->__builtin_decode_delim(transport->wpos_ + n)
+                         : transport->ctx_->decode_len(transport->buffer_, transport->wpos_ + n);
         if (length > 0)
         {
           int bytes_to_strip =
@@ -1792,6 +3064,12 @@ void io_service::remove_timer(highp_timer* timer)
 }
 void io_service::open_internal(io_channel* ctx, bool ignore_state)
 {
+  if (ctx->properties_ & YCPF_RECONNECTING)
+  { // opened by user, cancel the pending reconnect
+    ctx->properties_ &= ~YCPF_RECONNECTING;
+    ctx->timer_.cancel();
+  }
+
   if (ctx->state_ == io_base::state::OPENING && !ignore_state)
   { // in-opening, do nothing
     YASIO_SLOG("[index: %d] the channel is in opening!", ctx->index_);
@@ -1800,6 +3078,7 @@ void io_service::open_internal(io_channel* ctx, bool ignore_state)
 
   close_internal(ctx);
 
+  ctx->configure_decode_len();
   ctx->opmask_ |= YOPM_OPEN_CHANNEL;
 
   this->channel_ops_mtx_.lock();
@@ -1812,7 +3091,8 @@ void io_service::open_internal(io_channel* ctx, bool ignore_state)
 }
 bool io_service::close_internal(io_channel* ctx)
 {
-  if (ctx->socket_->is_open())
+  // The happy eyeballs connect aborts at event loop thread, see do_connect_attempts_completion
+  if (ctx->socket_->is_open() || !ctx->connect_attempts_.empty())
   {
     if (ctx->properties_ & YCM_CLIENT)
     {
@@ -1908,7 +3188,7 @@ bool io_service::cleanup_io(io_base* obj, bool clear_state)
   obj->opmask_ = 0;
   if (clear_state)
     obj->state_ = io_base::state::CLOSED;
-  if (obj->socket_->is_open())
+  if (obj->socket_ && obj->socket_->is_open())
   {
     unregister_descriptor(obj->socket_->native_handle(), YEM_POLLIN | YEM_POLLOUT);
     obj->socket_->close();
@@ -1918,51 +3198,110 @@ bool io_service::cleanup_io(io_base* obj, bool clear_state)
 }
 u_short io_service::query_ares_state(io_channel* ctx)
 {
-  if ((ctx->dns_queries_state_ & YDQSF_QUERIES_NEEDED) &&
-      !YDQS_CHECK_STATE(ctx->dns_queries_state_, YDQS_INPRROGRESS))
+  if (ctx->dns_queries_state_ & YDQSF_QUERIES_NEEDED)
   {
-    auto diff = (highp_clock() - ctx->dns_queries_timestamp_);
-    if (YDQS_CHECK_STATE(ctx->dns_queries_state_, YDQS_READY) &&
-        diff >= options_.dns_cache_timeout_)
-      YDQS_SET_STATE(ctx->dns_queries_state_, YDQS_DIRTY);
-
-    if (YDQS_CHECK_STATE(ctx->dns_queries_state_, YDQS_DIRTY))
-      start_resolve(ctx);
+    char suffix[sizeof ":65535:65535"];
+    snprintf(suffix, sizeof(suffix), ":%u:%d", ctx->remote_port_, resolv_family());
+    auto key = ctx->remote_host_ + suffix;
+    auto now = highp_clock();
+    if (this->dns_cache_.find(key) == this->dns_cache_.end())
+      purge_dns_cache(now);
+    auto& record = this->dns_cache_[key];
+
+    if (record && record->refresh_)
+    {
+      auto state = YDQS_GET_STATE(record->refresh_->state_);
+      if (state == YDQS_READY || now >= record->expire_time_)
+        record = std::move(record->refresh_);
+      else if (state == YDQS_FAILED) // keep the record valid until expired
+        record->refresh_.reset();
+    }
+    if (!record ||
+        (!YDQS_CHECK_STATE(record->state_, YDQS_INPRROGRESS) && now >= record->expire_time_))
+      record = start_resolve(ctx);
+    else if (YDQS_CHECK_STATE(record->state_, YDQS_READY) && now >= record->prefetch_time_ &&
+             !record->refresh_)
+      record->refresh_ = start_resolve(ctx);
+
+    auto state = YDQS_GET_STATE(record->state_);
+    switch (state)
+    {
+      case YDQS_READY:
+        ctx->remote_eps_ = record->endpoints_;
+        break;
+      case YDQS_INPRROGRESS:
+        ctx->set_last_errno(EINPROGRESS);
+#if defined(YASIO_HAVE_CARES)
+        if (!YDQS_CHECK_STATE(ctx->dns_queries_state_, YDQS_INPRROGRESS))
+        { // Cancel the queries if the channel waiting too long
+          auto pending = record;
+          ctx->timer_.expires_from_now(std::chrono::microseconds(options_.dns_queries_timeout_));
+          ctx->timer_.async_wait_once([=]() {
+            if (YDQS_CHECK_STATE(pending->state_, YDQS_INPRROGRESS))
+              ::ares_cancel(this->ares_);
+          });
+        }
+#endif
+        break;
+      default:
+        ctx->remote_eps_.clear();
+    }
+#if defined(YASIO_HAVE_CARES)
+    if (state != YDQS_INPRROGRESS && YDQS_CHECK_STATE(ctx->dns_queries_state_, YDQS_INPRROGRESS))
+      ctx->timer_.cancel();
+#endif
+    YDQS_SET_STATE(ctx->dns_queries_state_, state);
   }
 
   return YDQS_GET_STATE(ctx->dns_queries_state_);
 }
-void io_service::start_resolve(io_channel* ctx)
+void io_service::purge_dns_cache(highp_time_t now)
+{
+  // The in progress records are referenced by c-ares callback with raw pointer, keep them
+  auto in_progress = [](const dns_record_ptr& record) {
+    return record && YDQS_CHECK_STATE(record->state_, YDQS_INPRROGRESS);
+  };
+  for (auto it = this->dns_cache_.begin(); it != this->dns_cache_.end();)
+  {
+    auto& record = it->second;
+    if (!record || (now >= record->expire_time_ && record.use_count() == 1 &&
+                    !in_progress(record) && !in_progress(record->refresh_)))
+      it = this->dns_cache_.erase(it);
+    else
+      ++it;
+  }
+}
+io_service::dns_record_ptr io_service::start_resolve(io_channel* ctx)
 { // Only call at event-loop thread, so
   // no need to consider thread safe.
-  assert(YDQS_CHECK_STATE(ctx->dns_queries_state_, YDQS_DIRTY));
-  ctx->set_last_errno(EINPROGRESS);
-  YDQS_SET_STATE(ctx->dns_queries_state_, YDQS_INPRROGRESS);
+  auto record      = std::make_shared<dns_record>();
+  record->state_   = YDQS_INPRROGRESS;
+  record->host_    = ctx->remote_host_;
+  record->service_ = this;
 
   YASIO_SLOG("[index: %d] resolving %s", ctx->index_, ctx->remote_host_.c_str());
-  ctx->remote_eps_.clear();
 
 #if defined(YASIO_ENABLE_ARES_PROFILER)
-  ctx->ares_start_time_ = highp_clock();
+  record->start_time_ = highp_clock();
 #endif
 #if !defined(YASIO_HAVE_CARES)
-  std::thread async_resolv_thread([=] {
-    int error = options_.resolv_(ctx->remote_eps_, ctx->remote_host_.c_str(), ctx->remote_port_);
+  // The identical lookups are merged by dns cache, so only one task per host in flight
+  auto port = ctx->remote_port_;
+  resolv_pool_.run_task([=] {
+    std::vector<ip::endpoint> endpoints;
+    int error = options_.resolv_(endpoints, record->host_.c_str(), port);
     if (error == 0)
     {
-      ctx->dns_queries_state_     = YDQS_READY;
-      ctx->dns_queries_timestamp_ = highp_clock();
 #  if defined(YASIO_ENABLE_ARES_PROFILER)
-      YASIO_SLOG("[index: %d] resolve %s succeed, cost: %g(ms)", ctx->index_,
-                 ctx->remote_host_.c_str(),
-                 (ctx->dns_queries_timestamp_ - ctx->ares_start_time_) / 1000.0);
+      YASIO_SLOG("resolve %s succeed, cost: %g(ms)", record->host_.c_str(),
+                 (highp_clock() - record->start_time_) / 1000.0);
 #  endif
     }
     else
     {
-      YASIO_SLOG("[index: %d] resolve %s failed, ec=%d, detail:%s", ctx->index_,
-                 ctx->remote_host_.c_str(), error, xxsocket::gai_strerror(error));
-      YDQS_SET_STATE(ctx->dns_queries_state_, YDQS_FAILED);
+      YASIO_SLOG("resolve %s failed, ec=%d, detail:%s", record->host_.c_str(), error,
+                 xxsocket::gai_strerror(error));
+      endpoints.clear();
     }
     /*
     The getaddrinfo behavior at win32 is strange:
@@ -1976,13 +3315,14 @@ void io_service::start_resolve(io_channel* ctx)
     Another result at this situation is: Try get local endpoint by getsockname
     will return 0.0.0.0
     */
+    std::lock_guard<std::mutex> lck(resolv_completions_mtx_);
+    resolv_completions_.emplace_back(record, std::move(endpoints));
     this->interrupt();
   });
-  async_resolv_thread.detach();
 #else
   ares_addrinfo_hints hint;
   memset(&hint, 0x0, sizeof(hint));
-  hint.ai_family = (this->ipsv_ & ipsv_ipv4) ? hint.ai_family = AF_INET : AF_INET6;
+  hint.ai_family = resolv_family();
   char sport[sizeof "65535"] = {'\0'};
   const char* service = nullptr;
   if (ctx->remote_port_ > 0)
@@ -1991,20 +3331,55 @@ void io_service::start_resolve(io_channel* ctx)
     service = sport;
   }
 
-  ctx->timer_.expires_from_now(std::chrono::microseconds(options_.dns_queries_timeout_));
-  ctx->timer_.async_wait_once([=]() {
-    ::ares_cancel(this->ares_);
-    handle_connect_failed(ctx, YERR_RESOLV_HOST_FAILED);
-  });
+  // The record is kept alive by dns cache until resolved
   ares_work_started();
-  ::ares_getaddrinfo(this->ares_, ctx->remote_host_.c_str(), service, &hint,
-                     io_service::ares_getaddrinfo_cb, ctx);
+  ::ares_getaddrinfo(this->ares_, record->host_.c_str(), service, &hint,
+                     io_service::ares_getaddrinfo_cb, record.get());
 #endif
+  return record;
+}
+void io_service::complete_resolve(dns_record* record, highp_time_t ttl)
+{
+  auto now = highp_clock();
+  if (!record->endpoints_.empty())
+  { // Honor the record ttl if resolver reports it
+    yasio__interleave_families(record->endpoints_);
+    if (ttl <= 0)
+      ttl = options_.dns_cache_timeout_;
+    record->expire_time_   = now + ttl;
+    record->prefetch_time_ = now + ttl / 100 * YASIO_DNS_PREFETCH_PERCENT;
+    record->state_         = YDQS_READY;
+  }
+  else
+  {
+    record->expire_time_ = now + options_.dns_negative_cache_timeout_;
+    record->state_       = YDQS_FAILED;
+  }
+  this->interrupt();
+}
+#if !defined(YASIO_HAVE_CARES)
+void io_service::process_resolv_completions()
+{
+  std::vector<std::pair<dns_record_ptr, std::vector<ip::endpoint>>> completions;
+  {
+    std::lock_guard<std::mutex> lck(resolv_completions_mtx_);
+    if (resolv_completions_.empty())
+      return;
+    completions.swap(resolv_completions_);
+  }
+  for (auto& completion : completions)
+  {
+    completion.first->endpoints_ = std::move(completion.second);
+    complete_resolve(completion.first.get(), 0);
+  }
 }
+#endif
 int io_service::builtin_resolv(std::vector<ip::endpoint>& endpoints, const char* hostname,
                                  unsigned short port)
 {
-  if (this->ipsv_ & ipsv_ipv4)
+  if (this->ipsv_ == ipsv_dual_stack)
+    return xxsocket::resolve(endpoints, hostname, port);
+  else if (this->ipsv_ & ipsv_ipv4)
     return xxsocket::resolve_v4(endpoints, hostname, port);
   else if (this->ipsv_ & ipsv_ipv6) // localhost is IPv6_only network
     return xxsocket::resolve_v6(endpoints, hostname, port) != 0
@@ -2031,6 +3406,8 @@ const char* io_service::strerror(int error)
       return "Invalid packet!";
     case YERR_SSL_HANDSHAKE_FAILED:
       return "SSL handeshake failed!";
+    case YERR_KCP_SEND_FAILED:
+      return "KCP send message failed!";
     case -1:
       return "Unknown error!";
     default:
@@ -2070,6 +3447,20 @@ void io_service::set_option_internal(int opt, va_list ap) // lgtm [cpp/poorly-do
     case YOPT_S_SSL_CACERT:
       this->options_.capath_ = va_arg(ap, const char*);
       break;
+    case YOPT_S_SSL_SESSION_CACHE:
+      this->options_.ssl_session_cache_ = !!va_arg(ap, int);
+      break;
+    case YOPT_S_SSL_CERT:
+      this->options_.certfile_ = va_arg(ap, const char*);
+      this->options_.keyfile_  = va_arg(ap, const char*);
+      break;
+    case YOPT_S_SSL_KTLS:
+      this->options_.ssl_ktls_ = !!va_arg(ap, int);
+      break;
+    case YOPT_S_SSL_HANDSHAKE_THREADS:
+      this->options_.ssl_handshake_threads_ = (std::max)(va_arg(ap, int), 0);
+      ssl_pool_.set_max_threads(options_.ssl_handshake_threads_);
+      break;
 #endif
     case YOPT_S_CONNECT_TIMEOUT:
       options_.connect_timeout_ = static_cast<highp_time_t>(va_arg(ap, int)) * std::micro::den;
@@ -2080,6 +3471,19 @@ void io_service::set_option_internal(int opt, va_list ap) // lgtm [cpp/poorly-do
     case YOPT_S_DNS_QUERIES_TIMEOUT:
       options_.dns_queries_timeout_ = static_cast<highp_time_t>(va_arg(ap, int)) * std::micro::den;
       break;
+    case YOPT_S_DNS_NEGATIVE_CACHE_TIMEOUT:
+      options_.dns_negative_cache_timeout_ =
+          static_cast<highp_time_t>(va_arg(ap, int)) * std::micro::den;
+      break;
+    case YOPT_S_CONNECT_ATTEMPT_DELAY:
+      options_.connect_attempt_delay_ =
+          static_cast<highp_time_t>(va_arg(ap, int)) * std::milli::den;
+      break;
+    case YOPT_S_RESOLV_THREADS:
+#if !defined(YASIO_HAVE_CARES)
+      resolv_pool_.set_max_threads(va_arg(ap, int));
+#endif
+      break;
     case YOPT_C_LFBFD_PARAMS: {
       auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
       if (channel)
@@ -2088,6 +3492,20 @@ void io_service::set_option_internal(int opt, va_list ap) // lgtm [cpp/poorly-do
         channel->lfb_.length_field_offset = va_arg(ap, int);
         channel->lfb_.length_field_length = va_arg(ap, int);
         channel->lfb_.length_adjustment   = va_arg(ap, int);
+        channel->configure_decode_len();
+      }
+      break;
+    }
+    case YOPT_C_DBFD_PARAMS: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+      {
+        auto delimiter = va_arg(ap, const char*);
+        auto length    = ::yasio::clamp(va_arg(ap, int), 0, YASIO_MAX_DELIMITER);
+        if (length > 0)
+          ::memcpy(channel->dbf_.delimiter, delimiter, length);
+        channel->dbf_.delimiter_length = length;
+        channel->dbf_.max_frame_length = va_arg(ap, int);
       }
       break;
     }
@@ -2153,6 +3571,74 @@ void io_service::set_option_internal(int opt, va_list ap) // lgtm [cpp/poorly-do
         channel->disable_multicast_group();
       break;
     }
+#if defined(YASIO_HAVE_KCP)
+    case YOPT_C_KCP_NODELAY: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+      {
+        channel->kcp_.nodelay  = va_arg(ap, int);
+        channel->kcp_.interval = va_arg(ap, int);
+        channel->kcp_.resend   = va_arg(ap, int);
+        channel->kcp_.nc       = va_arg(ap, int);
+      }
+      break;
+    }
+    case YOPT_C_KCP_WINDOW_SIZE: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+      {
+        channel->kcp_.sndwnd = va_arg(ap, int);
+        channel->kcp_.rcvwnd = va_arg(ap, int);
+      }
+      break;
+    }
+    case YOPT_C_KCP_MTU: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+        channel->kcp_.mtu = va_arg(ap, int);
+      break;
+    }
+    case YOPT_C_KCP_ADAPTIVE: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+        channel->kcp_.max_wnd = va_arg(ap, int);
+      break;
+    }
+    case YOPT_C_KCP_FEC: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+      {
+        channel->kcp_.fec_data   = ::yasio::clamp(va_arg(ap, int), 1, (int)fec_shard::max_data);
+        channel->kcp_.fec_parity = ::yasio::clamp(va_arg(ap, int), 0, (int)fec_shard::max_parity);
+      }
+      break;
+    }
+    case YOPT_C_KCP_CONV: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+        channel->kcp_.conv = static_cast<uint32_t>(va_arg(ap, int));
+      break;
+    }
+    case YOPT_C_KCP_IDLE_TIMEOUT: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+        channel->kcp_.idle_timeout = (std::max)(va_arg(ap, int), 0);
+      break;
+    }
+#endif
+    case YOPT_C_RECONNECT: {
+      auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
+      if (channel)
+      {
+        auto& policy         = channel->reconnect_;
+        policy.initial_delay = (std::max)(va_arg(ap, int), 0);
+        policy.max_delay     = (std::max)(va_arg(ap, int), policy.initial_delay);
+        policy.multiplier    = (std::max)(va_arg(ap, int), 1);
+        policy.jitter        = ::yasio::clamp(va_arg(ap, int), 0, 100);
+        policy.max_attempts  = (std::max)(va_arg(ap, int), 0);
+      }
+      break;
+    }
     case YOPT_C_MOD_FLAGS: {
       auto channel = cindex_to_handle(static_cast<size_t>(va_arg(ap, int)));
       if (channel)
@@ -2176,6 +3662,98 @@ void io_service::set_option_internal(int opt, va_list ap) // lgtm [cpp/poorly-do
     }
   }
 }
+
+io_pool::io_pool(io_service& service, int first, int count, int kind)
+    : service_(service), first_(first), kind_(kind), states_(count, state::CLOSED),
+      transports_(count, nullptr)
+{}
+void io_pool::warmup(int count)
+{
+  std::lock_guard<std::mutex> lck(mtx_);
+  warmup_ = (std::min)(count, static_cast<int>(states_.size()));
+  replenish(warmup_);
+}
+transport_handle_t io_pool::acquire()
+{
+  std::lock_guard<std::mutex> lck(mtx_);
+  transport_handle_t transport = nullptr;
+  if (!idles_.empty())
+  {
+    auto index = idles_.back();
+    idles_.pop_back();
+    states_[index] = state::BUSY;
+    transport      = transports_[index];
+  }
+  replenish(transport ? warmup_ : (std::max)(warmup_, 1));
+  return transport;
+}
+void io_pool::release(transport_handle_t transport, bool reusable)
+{
+  std::lock_guard<std::mutex> lck(mtx_);
+  // Never dereference the transport, it's deallocated by io_service if lost when checked out
+  auto it = std::find(transports_.begin(), transports_.end(), transport);
+  if (!transport || it == transports_.end())
+    return;
+  auto index = static_cast<int>(it - transports_.begin());
+  if (states_[index] != state::BUSY)
+    return;
+  if (reusable)
+  {
+    states_[index] = state::IDLE;
+    idles_.push_back(index);
+  }
+  else
+    service_.close(transport); // the channel will be reused at YEK_CONNECTION_LOST
+}
+bool io_pool::on_event(const event_ptr& event)
+{
+  auto index = event->cindex() - first_;
+  if (index < 0 || index >= static_cast<int>(states_.size()))
+    return false;
+
+  std::lock_guard<std::mutex> lck(mtx_);
+  switch (event->kind())
+  {
+    case YEK_CONNECT_RESPONSE:
+      if (event->status() == 0)
+      {
+        states_[index]     = state::IDLE;
+        transports_[index] = event->transport();
+        idles_.push_back(index);
+      }
+      else // don't retry here to avoid busy loop when the server down, the next acquire will do
+        states_[index] = state::CLOSED;
+      return true;
+    case YEK_CONNECTION_LOST:
+      if (states_[index] == state::IDLE)
+        idles_.erase(std::find(idles_.begin(), idles_.end(), index));
+      states_[index]     = state::CLOSED;
+      transports_[index] = nullptr;
+      replenish(warmup_);
+      return true;
+  }
+  return false;
+}
+int io_pool::idle_count() const
+{
+  std::lock_guard<std::mutex> lck(mtx_);
+  return static_cast<int>(idles_.size());
+}
+void io_pool::replenish(int count)
+{
+  int ready = static_cast<int>(std::count_if(states_.begin(), states_.end(), [](state value) {
+    return value == state::IDLE || value == state::OPENING;
+  }));
+  for (size_t index = 0; ready < count && index < states_.size(); ++index)
+  {
+    if (states_[index] == state::CLOSED)
+    {
+      states_[index] = state::OPENING;
+      service_.open(first_ + index, kind_);
+      ++ready;
+    }
+  }
+}
 } // namespace inet
 } // namespace yasio
 
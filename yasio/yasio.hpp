@@ -38,9 +38,13 @@ SOFTWARE.
 #include <vector>
 #include <chrono>
 #include <functional>
-#if defined(_WIN32)
+#include <unordered_map>
+#if defined(_WIN32) || defined(YASIO_HAVE_KCP)
 #  include <map>
 #endif
+#if defined(YASIO_HAVE_KCP)
+#  include "yasio/detail/fec.hpp"
+#endif
 #include "yasio/detail/sz.hpp"
 #include "yasio/detail/config.hpp"
 #include "yasio/detail/endian_portable.hpp"
@@ -49,6 +53,9 @@ SOFTWARE.
 #include "yasio/detail/select_interrupter.hpp"
 #include "yasio/detail/concurrent_queue.hpp"
 #include "yasio/detail/utils.hpp"
+#if !defined(YASIO_HAVE_CARES) || defined(YASIO_HAVE_SSL)
+#  include "yasio/detail/thread_pool.hpp"
+#endif
 #include "yasio/cxx17/string_view.hpp"
 #include "yasio/xxsocket.hpp"
 
@@ -59,6 +66,7 @@ typedef struct IKCPCB ikcpcb;
 #if defined(YASIO_HAVE_SSL)
 typedef struct ssl_ctx_st SSL_CTX;
 typedef struct ssl_st SSL;
+typedef struct ssl_session_st SSL_SESSION;
 #endif
 
 #if defined(YASIO_HAVE_CARES)
@@ -68,6 +76,7 @@ typedef struct ares_addrinfo ares_addrinfo;
 
 namespace yasio
 {
+class chain_obstream;
 namespace inet
 {
 // options
@@ -106,7 +115,7 @@ enum
   // params: connect_timeout:int(10)
   YOPT_S_CONNECT_TIMEOUT,
 
-  // Set dns cache timeout in seconds
+  // Set dns cache timeout in seconds, used when the resolver doesn't report the record ttl
   // params: dns_cache_timeout : int(600),
   YOPT_S_DNS_CACHE_TIMEOUT,
 
@@ -114,6 +123,40 @@ enum
   // params: dns_queries_timeout : int(10)
   YOPT_S_DNS_QUERIES_TIMEOUT,
 
+  // Set dns negative cache timeout in seconds, the failed resolve is cached for this duration
+  // params: dns_negative_cache_timeout : int(10)
+  YOPT_S_DNS_NEGATIVE_CACHE_TIMEOUT,
+
+  // Set max threads of resolver thread pool, only works when without c-ares
+  // params: resolv_threads : int(4)
+  YOPT_S_RESOLV_THREADS,
+
+  // Set delay in milliseconds between the happy eyeballs connection attempts, the tcp client
+  // connects the resolved endpoints one by one without waiting the previous attempt complete, the
+  // first established wins, see RFC 8305
+  // params: attempt_delay : int(250), 0 means connect the first endpoint only
+  YOPT_S_CONNECT_ATTEMPT_DELAY,
+
+  // Sets whether reuse the ssl client sessions(include TLS 1.3 tickets) by remote host and port,
+  // the reconnect resumes the last session to avoid a full handshake
+  // params: enable:int(1)
+  YOPT_S_SSL_SESSION_CACHE,
+
+  // Sets ssl server certificate chain and private key(.pem) files, for YCK_SSL_SERVER
+  // params: certfile:const char*, keyfile:const char*
+  YOPT_S_SSL_CERT,
+
+  // Sets the threads to run ssl server handshakes, the crypto of handshake storms doesn't stall
+  // the event loop thread
+  // params: threads:int(0), 0 means run handshakes at event loop thread
+  YOPT_S_SSL_HANDSHAKE_THREADS,
+
+  // Sets whether enable kernel tls(linux only), the established ssl transports write to socket
+  // directly when OpenSSL enabled kernel record encryption, otherwise fall back to userspace tls.
+  // It requires OpenSSL 3.0+ built with ktls and the kernel tls module.
+  // params: enable:int(0)
+  YOPT_S_SSL_KTLS,
+
   // Sets channel length field based frame decode function, native C++ ONLY
   // params: index:int, func:decode_len_fn_t*
   YOPT_C_LFBFD_FN = 101,
@@ -161,6 +204,56 @@ enum
   // params: index:int
   YOPT_C_DISABLE_MCAST,
 
+  // Sets channel kcp nodelay params, for kcp channel only
+  // params: index:int, nodelay:int(1), interval:int(10), resend:int(2), nc:int(1)
+  YOPT_C_KCP_NODELAY,
+
+  // Sets channel kcp window size in packets, 0 means use kcp default value
+  // params: index:int, sndwnd:int(32), rcvwnd:int(128)
+  YOPT_C_KCP_WINDOW_SIZE,
+
+  // Sets channel kcp mtu, 0 means use kcp default value
+  // params: index:int, mtu:int(1400)
+  YOPT_C_KCP_MTU,
+
+  // Sets channel kcp adaptive profile, grows window from observed RTT and loss until max_wnd,
+  // the receive window is max_wnd, so set it at both sides
+  // params: index:int, max_wnd:int(0), 0 means disable adaptive profile
+  YOPT_C_KCP_ADAPTIVE,
+
+  // Sets channel kcp conversation id, for kcp client only, the server accepts any conv
+  // and assigns one when the client channel has flag YCF_KCP_HANDSHAKE
+  // params: index:int, conv:int(0)
+  YOPT_C_KCP_CONV,
+
+  // Sets channel kcp XOR parity fec, every data_shards datagrams are followed by parity_shards
+  // parity datagrams, must be same at both sides
+  // params: index:int, data_shards:int(10), parity_shards:int(3), 0 means disable fec
+  YOPT_C_KCP_FEC,
+
+  // Sets channel reconnect policy, for client channel only, the channel is reopened automatically
+  // after connect failed or connection lost, but never after closed by local.
+  // The delay of n-th attempt is min(initial_delay * multiplier^(n-1), max_delay) +/- jitter%
+  // params: index:int, initial_delay:int(0, ms), max_delay:int(30000, ms), multiplier:int(2),
+  //         jitter:int(20, percent), max_attempts:int(0)
+  // remark: initial_delay 0 means disable, max_attempts 0 means unlimited
+  YOPT_C_RECONNECT,
+
+  // Sets channel delimiter based frame decode params, the frame ends with the delimiter bytes,
+  // such as "\r\n" or "\n", the packet includes the delimiter. The scanned bytes are never
+  // rescanned when the frame arrives in pieces.
+  // params:
+  //     index:int,
+  //     delimiter:const char*,
+  //     delimiter_length:int(0), 0: disabled, use the length field based decoding, max 8 bytes
+  //     max_frame_length:int(64KBytes), limited by the receive buffer size
+  YOPT_C_DBFD_PARAMS,
+
+  // Sets channel kcp server session idle timeout, the session which receives nothing in it or
+  // whose segments exceed the kcp dead link retransmissions is closed with ETIMEDOUT
+  // params: index:int, timeout:int(60000, ms), 0 means never
+  YOPT_C_KCP_IDLE_TIMEOUT,
+
   // Sets io_base sockopt
   // params: io_base*,level:int,optname:int,optval:int,optlen:int
   YOPT_SOCKOPT = 201,
@@ -187,6 +280,9 @@ enum
   YCK_KCP_CLIENT = YCM_KCP | YCM_CLIENT | YCM_UDP,
   YCK_KCP_SERVER = YCM_KCP | YCM_SERVER | YCM_UDP,
   YCK_SSL_CLIENT = YCM_SSL | YCM_CLIENT | YCM_TCP,
+  // The accepted connections are reported after ssl handshake, the handshake not completed in
+  // connect timeout is dropped silently, see YOPT_S_SSL_CERT, YOPT_S_CONNECT_TIMEOUT
+  YCK_SSL_SERVER = YCM_SSL | YCM_SERVER | YCM_TCP,
 };
 
 // channel flags
@@ -199,6 +295,18 @@ enum
      https://docs.microsoft.com/en-us/windows/win32/winsock/using-so-reuseaddr-and-so-exclusiveaddruse
   */
   YCF_EXCLUSIVEADDRUSE = 1 << 10,
+
+  /* For kcp client only, whether request a conv id from kcp server before connection established,
+     the server sessions of one listening socket are identified by conv id, see YOPT_C_KCP_CONV
+  */
+  YCF_KCP_HANDSHAKE = 1 << 11,
+
+  /* For udp/kcp, whether probe the path mtu with don't fragment datagrams, the kcp mtu follows the
+     probed value, see io_transport_udp::mtu, must be set at both sides.
+     Once the probing started, the datagrams larger than the path mtu are dropped instead of
+     fragmented.
+  */
+  YCF_PMTUD = 1 << 12,
 };
 
 // event kinds
@@ -216,7 +324,7 @@ class io_event;
 class io_channel;
 class io_transport;
 class io_transport_tcp; // tcp client/server
-class io_transport_ssl; // ssl client
+class io_transport_ssl; // ssl client/server
 class io_transport_udp; // udp client/server
 class io_transport_kcp; // kcp client/server
 class io_service;
@@ -239,6 +347,54 @@ typedef std::function<void(event_ptr&&)> io_event_cb_t;
 typedef std::function<int(void* ptr, int len)> decode_len_fn_t;
 typedef std::function<int(std::vector<ip::endpoint>&, const char*, unsigned short)> resolv_fn_t;
 typedef std::function<void(const char*)> print_fn_t;
+typedef int (*lfb_decode_len_fn_t)(const void* ptr, int len, int offset, int adjustment,
+                                   int max_frame_length);
+
+/*
+** The length field based frame decoders, the length field is 1~4 bytes big endian integer at
+** 'offset' of the frame, and the frame length is the field value + 'adjustment'.
+** They are instantiated for each field size at compile time, and the channel selects one when
+** it opens, so the decoding of each frame is an inlined load & bswap without any branch on params.
+*/
+namespace detail
+{
+template <int _Size> inline uint32_t lfb_load(const unsigned char* ptr);
+template <> inline uint32_t lfb_load<1>(const unsigned char* ptr) { return *ptr; }
+template <> inline uint32_t lfb_load<2>(const unsigned char* ptr)
+{
+  uint16_t value;
+  ::memcpy(&value, ptr, sizeof(value));
+  return ntohs(value);
+}
+template <> inline uint32_t lfb_load<3>(const unsigned char* ptr)
+{
+  uint32_t value = 0;
+  ::memcpy(&value, ptr, 3);
+  return ntohl(value) >> 8;
+}
+template <> inline uint32_t lfb_load<4>(const unsigned char* ptr)
+{
+  uint32_t value;
+  ::memcpy(&value, ptr, sizeof(value));
+  return ntohl(value);
+}
+} // namespace detail
+
+// returns -1 if the length exceeds 'max_frame_length', 0 if the length field incomplete
+template <int _Size>
+inline int lfb_decode_len(const void* ptr, int len, int offset, int adjustment,
+                          int max_frame_length)
+{
+  if (len < offset + _Size)
+    return 0;
+  int length = static_cast<int>(
+                   detail::lfb_load<_Size>(static_cast<const unsigned char*>(ptr) + offset)) +
+               adjustment;
+  return length <= max_frame_length ? length : -1;
+}
+
+// The length field offset -1, the bytes received are the frame
+inline int lfb_decode_len_directly(const void*, int len, int, int, int) { return len; }
 
 struct io_hostent
 {
@@ -387,8 +543,16 @@ private:
   YASIO__DECL void configure_host(std::string host);
   YASIO__DECL void configure_port(u_short port);
 
+  // Selects the builtin length field decoder of lfb_ params, call at channel open
+  YASIO__DECL void configure_decode_len();
+
   // -1 indicate failed, connection will be closed
-  YASIO__DECL int __builtin_decode_len(void* ptr, int len);
+  int decode_len(void* ptr, int len)
+  {
+    return decode_len_ ? decode_len_(ptr, len)
+                       : lfb_decode_len_(ptr, len, lfb_.length_field_offset,
+                                         lfb_.length_adjustment, lfb_.max_frame_length);
+  }
 
   /* Since v3.33.0 mask,kind,flags,private_flags are stored to this field
   ** bit[1-8] mask & kinds
@@ -411,14 +575,22 @@ private:
 
   std::atomic<u_short> dns_queries_state_;
 
-  highp_time_t dns_queries_timestamp_ = 0;
-
   int index_;
   int protocol_ = 0;
 
-  // The timer for check resolve & connect timeout
+  // The timer for check resolve & connect timeout, and the reconnect delay
   highp_timer timer_;
 
+  struct __unnamed03
+  {
+    int initial_delay = 0; // milliseconds, 0: disabled
+    int max_delay     = 30000;
+    int multiplier    = 2;
+    int jitter        = 20; // percent
+    int max_attempts  = 0;  // 0: unlimited
+    int attempts      = 0;  // the attempts since last connected
+  } reconnect_;
+
   struct __unnamed01
   {
     int max_frame_length    = YASIO_SZ(10, M); // 10MBytes
@@ -427,7 +599,15 @@ private:
     int length_adjustment   = 0;
     int initial_bytes_to_strip = 0;
   } lfb_;
-  decode_len_fn_t decode_len_;
+  lfb_decode_len_fn_t lfb_decode_len_ = nullptr;
+  decode_len_fn_t decode_len_; // The user decoder set by YOPT_C_LFBFD_FN, overrides lfb_
+
+  struct __unnamed04
+  {
+    char delimiter[YASIO_MAX_DELIMITER];
+    int delimiter_length = 0; // 0: disabled
+    int max_frame_length = YASIO_INET_BUFFER_SIZE;
+  } dbf_;
 
   /*
   !!! for tcp/udp client to connect remote host.
@@ -437,6 +617,11 @@ private:
   std::string remote_host_;
   std::vector<ip::endpoint> remote_eps_;
 
+  // tcp client only, the sockets of happy eyeballs connection attempts in progress
+  std::vector<std::shared_ptr<xxsocket>> connect_attempts_;
+  // the index of remote_eps_ to attempt next
+  size_t next_attempt_ = 0;
+
   ip::endpoint multiaddr_;
 
   // Current it's only for UDP
@@ -444,10 +629,53 @@ private:
 
 #if defined(YASIO_HAVE_SSL)
   ssl_auto_handle ssl_;
+
+  // ssl server only, the accepted connections in handshaking
+  struct ssl_accept
+  {
+    std::shared_ptr<xxsocket> socket;
+    ssl_auto_handle ssl;
+    highp_time_t expire_time;
+    bool busy    = false; // the handshake step is running at ssl thread pool
+    bool dropped = false; // the channel closed when busy
+  };
+  std::vector<ssl_accept> ssl_accepts_;
+  highp_time_t ssl_accepts_deadline_ = 0; // the expire time of timer_, 0: not armed
 #endif
 
-#if defined(YASIO_ENABLE_ARES_PROFILER)
-  highp_time_t ares_start_time_;
+#if defined(YASIO_HAVE_KCP)
+  struct __unnamed02
+  {
+    int nodelay      = 1;
+    int interval     = 10;
+    int resend       = 2;
+    int nc           = 1;
+    int sndwnd       = 0; // 0: kcp default
+    int rcvwnd       = 0; // 0: kcp default
+    int mtu          = 0; // 0: kcp default
+    int max_wnd      = 0; // the max window of adaptive profile, 0: disabled
+    int fec_data     = 0; // the data shards of fec group
+    int fec_parity   = 0; // the parity shards of fec group, 0: fec disabled
+    uint32_t conv    = 0; // client only, the value assigned by server when YCF_KCP_HANDSHAKE
+    uint32_t nonce   = 0; // client only, identify the handshake in progress
+    // server only, milliseconds, 0: never
+    int idle_timeout = YASIO_KCP_IDLE_TIMEOUT;
+  } kcp_;
+
+  // kcp server only: all sessions share the listening socket, the datagrams are demuxed by conv
+  // id, the sessions with conv 0(the clients without handshake) are demuxed by endpoint.
+  std::unordered_map<uint32_t, io_transport_kcp*> kcp_sessions_;
+  std::map<ip::endpoint, io_transport_kcp*> kcp_peers_;
+
+  // kcp server only: the random conv replied to the handshake, the session is created when the
+  // first segment with it arrives, which proves the client owns the address.
+  struct kcp_handshake
+  {
+    uint32_t conv;
+    uint32_t nonce;
+    highp_time_t expire_time;
+  };
+  std::map<ip::endpoint, kcp_handshake> kcp_handshakes_;
 #endif
 };
 
@@ -480,9 +708,15 @@ protected:
   // Call at user thread
   virtual int write(std::vector<char>&&, std::function<void()>&&) = 0;
 
+  // Call at user thread, the transports not support scatter-gather write the flattened buffer
+  YASIO__DECL virtual int write_chain(chain_obstream&&, std::function<void()>&&);
+
   // Call at io_service
   YASIO__DECL virtual int do_read(int& error);
 
+  // Call at io_service, decodes the delimiter based frame length of recv buffer, -1 indicate failed
+  YASIO__DECL int __builtin_decode_delim(int n);
+
   // Call at io_service, try flush pending packet
   virtual bool do_write(long long& max_wait_duration) = 0;
 
@@ -497,7 +731,8 @@ protected:
   unsigned int id_;
 
   char buffer_[YASIO_INET_BUFFER_SIZE]; // recv buffer, 64K
-  int wpos_ = 0;                        // recv buffer write pos
+  int wpos_        = 0;                 // recv buffer write pos
+  int scan_offset_ = 0;                 // recv buffer bytes scanned without delimiter found
 
   std::vector<char> expected_packet_;
   int expected_size_ = -1;
@@ -506,6 +741,7 @@ protected:
 
   std::function<int(const void*, int)> write_cb_;
   std::function<int(void*, int)> read_cb_;
+  std::function<int(const cxx17::string_view*, int)> writev_cb_;
 
 public:
   // The user data
@@ -525,6 +761,7 @@ public:
 
 protected:
   YASIO__DECL int write(std::vector<char>&&, std::function<void()>&&) override;
+  YASIO__DECL int write_chain(chain_obstream&&, std::function<void()>&&) override;
   YASIO__DECL bool do_write(long long& max_wait_duration) override;
 
   concurrency::concurrent_queue<a_pdu_ptr> send_queue_;
@@ -556,12 +793,26 @@ public:
   // BSD UDP socket, once bind 4-tuple with 'connect', can't be unbind
   YASIO__DECL int connect();
 
+  // The max udp payload size which can reach the peer without fragmentation, it's
+  // YASIO_PMTUD_BASE until a larger size probed, see YCF_PMTUD
+  int mtu() const { return pmtu_.mtu; }
+
 protected:
   YASIO__DECL int write_to(std::vector<char>&&, const ip::endpoint&) override;
   YASIO__DECL int write(std::vector<char>&&, std::function<void()>&&) override;
-  // the udp write op not perform in io_service, so check status only
+  YASIO__DECL int do_read(int& error) override;
+  // the udp write op not perform in io_service, so check status and probe path mtu only
   YASIO__DECL bool do_write(long long& max_wait_duration) override;
 
+  // Replies the path mtu probe and handles the ack, returns false if it's not a probe packet
+  YASIO__DECL bool handle_pmtu_packet(char* data, int len);
+
+  // Binary searches the path mtu with the don't fragment probes
+  YASIO__DECL void probe_mtu(long long& max_wait_duration);
+  YASIO__DECL void send_mtu_probe();
+
+  virtual void on_mtu_changed() {}
+
   YASIO__DECL void set_primitives() override;
 
   // ensure peer valid, if not, assign from ctx_->remote_eps_[0]
@@ -572,10 +823,23 @@ protected:
 
   mutable ip::endpoint peer_;
   bool connected_ = false;
+
+  // The path mtu discovery state, sizes are udp payload size
+  struct __unnamed01
+  {
+    int mtu             = YASIO_PMTUD_BASE; // the max size acked by peer
+    int hi              = 0;                // the max size maybe ok, 0: probing not started
+    int probe           = 0;                // the size in flight, 0: no probe in flight
+    int tries           = 0;
+    highp_time_t expire = 0;
+    bool done           = false;
+  } pmtu_;
 };
 #if defined(YASIO_HAVE_KCP)
 class io_transport_kcp : public io_transport_udp
 {
+  friend class io_service;
+
 public:
   YASIO__DECL io_transport_kcp(io_channel* ctx, std::shared_ptr<xxsocket>& s);
   YASIO__DECL ~io_transport_kcp();
@@ -585,8 +849,41 @@ protected:
   YASIO__DECL int write(std::vector<char>&&, std::function<void()>&&) override;
   YASIO__DECL int do_read(int& error) override;
   YASIO__DECL bool do_write(long long& max_wait_duration) override;
+
+  // Input a datagram to kcp, decode it first when fec enabled, returns -1 if kcp rejects it
+  YASIO__DECL int kcp_input(const char* data, int len);
+
+  // Grows or shrinks the kcp window from observed RTT and loss, see YOPT_C_KCP_ADAPTIVE
+  YASIO__DECL void adapt_window(uint32_t current);
+
+  // Follows the probed path mtu, see YCF_PMTUD
+  YASIO__DECL void on_mtu_changed() override;
+
   ikcpcb* kcp_;
-  std::recursive_mutex send_mtx_;
+
+  // The user messages, feed to kcp at io_service thread, so kcp never be touched at user thread
+  concurrency::concurrent_queue<std::vector<char>> send_queue_;
+
+  // The nonce of client handshake which this server session accepted
+  uint32_t nonce_ = 0;
+
+  // The time of server session received the last valid datagram, see YOPT_C_KCP_IDLE_TIMEOUT
+  highp_time_t active_time_ = 0;
+
+  // The max message size ikcp_send accepts with current mss, checked at user thread
+  std::atomic<int> max_message_size_;
+
+  fec_encoder fec_encoder_;
+  fec_decoder fec_decoder_;
+
+  // The adaptive profile sample, all counters are snapshot at the begin of sample period
+  struct __unnamed02
+  {
+    uint32_t ts      = 0;
+    uint32_t snd_una = 0;
+    uint32_t snd_nxt = 0;
+    uint32_t xmit    = 0;
+  } sample_;
 };
 #endif
 
@@ -688,7 +985,7 @@ public:
 
   /*
   ** Summary: Write data to a TCP or connected UDP transport with last peer address
-  ** @retval: < 0: failed
+  ** @retval: < 0: failed, for KCP, the message is larger than 127 fragments of current mss
   ** @params:
   **        'thandle': the transport to write, could be tcp/udp/kcp
   **        'buf': the data to write
@@ -697,7 +994,7 @@ public:
   ** @remark:
   **        + TCP: Use queue to store user message, flush at io_service thread
   **        + UDP: Don't use queue, call low layer socket.sendto directly
-  **        + KCP: Use queue provided by kcp internal, flush at io_service thread
+  **        + KCP: Use queue to store user message, feed to kcp & flush at io_service thread
   */
   int write(transport_handle_t thandle, const void* buf, size_t len,
             std::function<void()> handler = nullptr)
@@ -707,12 +1004,21 @@ public:
   YASIO__DECL int write(transport_handle_t thandle, std::vector<char> buffer,
                         std::function<void()> = nullptr);
 
+  /*
+  ** Summary: Write the segments of a chain_obstream, the referenced blobs are not copied
+  ** @remark:
+  **        + TCP: Gather the segments with sendmsg/WSASend at io_service thread
+  **        + UDP/KCP: Write the flattened buffer
+  */
+  YASIO__DECL int write(transport_handle_t thandle, chain_obstream&& obs,
+                        std::function<void()> = nullptr);
+
   /*
   ** Summary: Write data to unconnected UDP transport with specified address.
   ** @retval: < 0: failed
   ** @remark: This function only for UDP like transport (UDP or KCP)
   **        + UDP: Don't use queue, call low layer socket.sendto directly
-  **        + KCP: Use the queue provided by kcp internal
+  **        + KCP: Use queue to store user message, feed to kcp at io_service thread
   */
   int write_to(transport_handle_t thandle, const void* buf, size_t len, const ip::endpoint& to)
   {
@@ -738,16 +1044,46 @@ private:
     return std::find_if(timer_queue_.begin(), timer_queue_.end(),
                         [=](const timer_impl_t& timer) { return timer.first == key; });
   }
+  // Compares the expire time, the wait duration changes during sort
   inline void sort_timers()
   {
     std::sort(this->timer_queue_.begin(), this->timer_queue_.end(),
               [](const timer_impl_t& lhs, const timer_impl_t& rhs) {
-                return lhs.first->wait_duration() > rhs.first->wait_duration();
+                return lhs.first->expire_time_ > rhs.first->expire_time_;
               });
   }
 
+  /* The dns cache record shared by the channels connect to same host, port and address family,
+  ** once resolved, the record is immutable until replaced by a new one.
+  */
+  struct dns_record
+  {
+    std::atomic<u_short> state_;
+    std::string host_;
+    std::vector<ip::endpoint> endpoints_;
+    // the positive or negative cache expired at
+    highp_time_t expire_time_ = 0;
+    // refresh ahead after it, see YASIO_DNS_PREFETCH_PERCENT
+    highp_time_t prefetch_time_ = 0;
+    // the prefetch in progress
+    std::shared_ptr<dns_record> refresh_;
+    io_service* service_;
+#if defined(YASIO_ENABLE_ARES_PROFILER)
+    highp_time_t start_time_;
+#endif
+  };
+  typedef std::shared_ptr<dns_record> dns_record_ptr;
+
   // Start a async resolve, It's only for internal use
-  YASIO__DECL void start_resolve(io_channel*);
+  YASIO__DECL dns_record_ptr start_resolve(io_channel*);
+
+  // Update the record with resolve result
+  YASIO__DECL void complete_resolve(dns_record* record, highp_time_t ttl);
+
+#if !defined(YASIO_HAVE_CARES)
+  // Apply the results posted by resolver thread pool
+  YASIO__DECL void process_resolv_completions();
+#endif
 
   YASIO__DECL void init(const io_hostent* channel_eps /* could be nullptr */, int channel_count);
   YASIO__DECL void dispose();
@@ -772,11 +1108,32 @@ private:
   YASIO__DECL void do_nonblocking_connect(io_channel*);
   YASIO__DECL void do_nonblocking_connect_completion(io_channel*, fd_set* fds_array);
 
+  // The happy eyeballs connect, see YOPT_S_CONNECT_ATTEMPT_DELAY
+  YASIO__DECL void start_connect_attempts(io_channel*);
+  // Connects next endpoint, returns 0 if started, otherwise the last error
+  YASIO__DECL int do_connect_attempt(io_channel*);
+  YASIO__DECL void do_connect_attempts_completion(io_channel*, fd_set* fds_array);
+  YASIO__DECL void close_connect_attempts(io_channel*);
+
 #if defined(YASIO_HAVE_SSL)
   YASIO__DECL void init_ssl_context();
   YASIO__DECL void cleanup_ssl_context();
   YASIO__DECL SSL_CTX* get_ssl_context();
   YASIO__DECL void do_ssl_handshake(io_channel*);
+
+  // The ssl server handshakes of accepted connections
+  YASIO__DECL void do_ssl_accept(io_channel*, std::shared_ptr<xxsocket>);
+  YASIO__DECL void do_ssl_accept_completion(io_channel*, fd_set* fds_array);
+  // Applies a handshake step result, returns false if the connection leaves handshaking
+  YASIO__DECL bool handle_ssl_accept_step(io_channel*, io_channel::ssl_accept&, int result);
+  YASIO__DECL void close_ssl_accepts(io_channel*);
+  // Apply the handshake steps posted by ssl thread pool
+  YASIO__DECL void process_ssl_completions();
+
+  // The ssl client session cache, see YOPT_S_SSL_SESSION_CACHE
+  YASIO__DECL static int ssl_new_session_cb(SSL*, SSL_SESSION*);
+  YASIO__DECL SSL_SESSION*& ssl_cached_session(io_channel*);
+  YASIO__DECL void clear_ssl_sessions();
 #endif
 
 #if defined(YASIO_HAVE_CARES)
@@ -798,6 +1155,8 @@ private:
   }
   YASIO__DECL void handle_connect_succeed(transport_handle_t);
   YASIO__DECL void handle_connect_failed(io_channel*, int ec);
+  // Reopens the client channel later by the reconnect policy, see YOPT_C_RECONNECT
+  YASIO__DECL void schedule_reconnect(io_channel*, int ec);
   YASIO__DECL void notify_connect_succeed(transport_handle_t);
 
   YASIO__DECL transport_handle_t allocate_transport(io_channel*, std::shared_ptr<xxsocket>);
@@ -832,14 +1191,24 @@ private:
   YASIO__DECL void clear_transports(); // destroy all transports
   YASIO__DECL bool close_internal(io_channel*);
 
+  // The address family to resolve, both families are resolved on dual stack for happy eyeballs
+  int resolv_family() const
+  {
+    return ipsv_ == ipsv_dual_stack ? AF_UNSPEC : (ipsv_ & ipsv_ipv4) ? AF_INET : AF_INET6;
+  }
+
   /*
   ** Summay: Query async resolve state for new endpoint set
   ** @retval:
   **   YDQS_READY, YDQS_INPRROGRESS, YDQS_FAILED
-  ** @remark: will start a async resolv when the state is: YDQS_DIRTY
+  ** @remark: will start a async resolv when the shared dns cache record missing or expired, and
+  **          prefetch it when it's about to expire
   */
   YASIO__DECL u_short query_ares_state(io_channel* ctx);
 
+  // Erase the expired dns cache records which no lookup in progress, call before a new host cached
+  YASIO__DECL void purge_dns_cache(highp_time_t now);
+
   // supporting server
   YASIO__DECL void do_nonblocking_accept(io_channel*);
   YASIO__DECL void do_nonblocking_accept_completion(io_channel*, fd_set* fds_array);
@@ -851,6 +1220,28 @@ private:
   */
   YASIO__DECL transport_handle_t do_dgram_accept(io_channel*, const ip::endpoint& peer);
 
+#if defined(YASIO_HAVE_KCP)
+  /*
+  ** Summary: For kcp-server only, demux the datagrams of listening socket to sessions
+  */
+  YASIO__DECL void do_kcp_accept_completion(io_channel*, fd_set* fds_array);
+  // Returns the random conv replied to the handshake request, 0 if too many handshakes
+  YASIO__DECL uint32_t do_kcp_handshake_accept(io_channel*, const ip::endpoint& peer,
+                                               uint32_t nonce);
+  // Creates a session for the first datagram of a client, returns nullptr if kcp rejects it, or
+  // it doesn't prove the ownership of the address
+  YASIO__DECL io_transport_kcp* do_kcp_accept(io_channel*, const ip::endpoint& peer, uint32_t conv,
+                                              const char* data, int len);
+  // Mark all sessions of kcp-server to close, call before the listening socket closed
+  YASIO__DECL void close_kcp_sessions(io_channel*);
+  // Remove the session from kcp-server and detach the shared listening socket
+  YASIO__DECL void unbind_kcp_session(io_transport_kcp*);
+
+  // For kcp-client only, request a conv id from kcp server
+  YASIO__DECL void do_kcp_handshake(io_channel*);
+  YASIO__DECL void do_kcp_handshake_completion(io_channel*, fd_set* fds_array);
+#endif
+
 private:
   state state_ = state::UNINITIALIZED; // The service state
   std::thread worker_;
@@ -891,9 +1282,11 @@ private:
   // options
   struct __unnamed_options
   {
-    highp_time_t connect_timeout_     = 10LL * std::micro::den;
-    highp_time_t dns_cache_timeout_   = 600LL * std::micro::den;
-    highp_time_t dns_queries_timeout_ = 10LL * std::micro::den;
+    highp_time_t connect_timeout_            = 10LL * std::micro::den;
+    highp_time_t dns_cache_timeout_          = 600LL * std::micro::den;
+    highp_time_t dns_queries_timeout_        = 10LL * std::micro::den;
+    highp_time_t dns_negative_cache_timeout_ = 10LL * std::micro::den;
+    highp_time_t connect_attempt_delay_      = 250LL * std::milli::den;
 
     bool deferred_event_ = true;
 
@@ -917,20 +1310,103 @@ private:
 #if defined(YASIO_HAVE_SSL)
     // The full path cacert(.pem) file for ssl verifaction
     std::string capath_;
+    bool ssl_session_cache_ = true;
+    // The ssl server certificate chain & private key files
+    std::string certfile_;
+    std::string keyfile_;
+    int ssl_handshake_threads_ = 0;
+    bool ssl_ktls_             = false;
 #endif
   } options_;
 
   // The ip stack version supported by localhost
   u_short ipsv_ = 0;
 
+  // The shared dns cache, key: host:port:family
+  std::unordered_map<std::string, dns_record_ptr> dns_cache_;
+
+#if !defined(YASIO_HAVE_CARES)
+  // The resolver threads, the results are posted back and applied at event loop thread
+  thread_pool resolv_pool_;
+  std::mutex resolv_completions_mtx_;
+  std::vector<std::pair<dns_record_ptr, std::vector<ip::endpoint>>> resolv_completions_;
+#endif
+
 #if defined(YASIO_HAVE_SSL)
-  SSL_CTX* ssl_ctx_ = nullptr;
+  SSL_CTX* ssl_ctx_        = nullptr;
+  SSL_CTX* ssl_server_ctx_ = nullptr;
+
+  // The last ssl client sessions, key: host:port
+  std::unordered_map<std::string, SSL_SESSION*> ssl_sessions_;
+
+  // The ssl server handshake threads, the step results are posted back and applied at event loop
+  // thread, see YOPT_S_SSL_HANDSHAKE_THREADS
+  struct ssl_completion
+  {
+    io_channel* ctx;
+    SSL* ssl;
+    int result;
+  };
+  thread_pool ssl_pool_;
+  std::mutex ssl_completions_mtx_;
+  std::vector<ssl_completion> ssl_completions_;
 #endif
 #if defined(YASIO_HAVE_CARES)
   ares_channel ares_         = nullptr; // the ares handle for non blocking io dns resolve support
   int ares_outstanding_work_ = 0;
 #endif
 }; // io_service
+
+/*
+** The client connection pool over the channels [first, first + count) of a io_service, all the
+** channels should have the same remote endpoint, see YOPT_C_REMOTE_ENDPOINT.
+** The connected transports are checked out and in without reconnect, and the pool opens channels
+** ahead of demand to keep 'warmup' idle transports. Enable YOPT_S_TCP_KEEPALIVE to detect the
+** broken idle transports.
+** @remark: The io_service events must be feed to io_pool::on_event.
+*/
+class io_pool
+{
+  enum class state
+  {
+    CLOSED,
+    OPENING,
+    IDLE,
+    BUSY,
+  };
+
+public:
+  YASIO__DECL io_pool(io_service& service, int first, int count, int kind = YCK_TCP_CLIENT);
+
+  // Keeps at least 'count' idle or opening transports, opens the channels immediately
+  YASIO__DECL void warmup(int count);
+
+  // Checks out a idle transport, returns nullptr if none and opens a channel for next acquire
+  YASIO__DECL transport_handle_t acquire();
+
+  // Checks in a transport, the not reusable transport will be closed, it's safe to release a
+  // transport which lost when checked out
+  YASIO__DECL void release(transport_handle_t, bool reusable = true);
+
+  // Feeds the io_service event, returns true if it's the connection event of pooled channels
+  YASIO__DECL bool on_event(const event_ptr& event);
+
+  YASIO__DECL int idle_count() const;
+
+private:
+  // Opens the closed channels until 'count' idle or opening
+  YASIO__DECL void replenish(int count);
+
+  io_service& service_;
+  int first_;
+  int kind_;
+  int warmup_ = 0;
+
+  std::vector<state> states_;
+  std::vector<transport_handle_t> transports_;
+  std::vector<int> idles_; // the idle channels, check out the most recently used first
+  mutable std::mutex mtx_;
+};
 } // namespace inet
 } /* namespace yasio */
 